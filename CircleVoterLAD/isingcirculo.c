@@ -20,7 +20,9 @@
 // -DSPEEDTEST [sweep and measure speed test]
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DPNGSNAPS [with SNAPSHOTS, PNG snapshots instead of EPS]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -37,6 +39,8 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -61,7 +65,7 @@
   #define RESET       2
 #endif
 
-#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 #define SIMPLIFIED  1 // 1 --> simplify the algorithm to alpha=beta=1 to avoid calculations
 
 /***************************************************************
@@ -73,8 +77,6 @@ void openfiles(void);
 void sweep(void); 
 void visualize(int,unsigned long); 
 void states(void); 
-void measures1(void); 
-void measures2(void);
 #ifdef SNAPSHOTS
   void snap(void);  
 #endif
@@ -89,7 +91,8 @@ bool probcheck(double);
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,**neigh,*memory,*measures,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+int *spin,**neigh,*memory,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+schedule measures;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2;
 int probperc0,probperc1;
 unsigned long seed;
@@ -127,13 +130,13 @@ int main(void){
         states();
         hoshen_kopelman();
         fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d\n",j,(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1);
-        while(measures[k]!=0){
-          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d\n",measures[k],(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1);
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d\n",sched_time(&measures,k),(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1);
           k++;
         }           
         break;
       }
-      if (measures[k]==j) {  
+      if (sched_time(&measures,k)==j) {  
         #if(SNAPSHOTS==1)
           snap();   
           k++;   
@@ -180,7 +183,6 @@ void initialize(void) {
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
   memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   zealot = malloc(N*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
@@ -243,9 +245,11 @@ void initialize(void) {
   }
 
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 
 }
@@ -291,37 +295,6 @@ void states(void) {
     if (spin[down[i]]!=spin[i]) activesum++;
   }
 }
- /**************************************************************
- *                       Measures Vector     // Medidas Logarítmicas
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
-    }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
- /**************************************************************
- *                       Measures Vector    // Número de medidas
- *************************************************************/
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
-  }
-  return;
-}
-
 /**************************************************************
  *                      Teste
  *************************************************************/
@@ -337,18 +310,28 @@ bool probcheck(double _ALPHA) {
  *************************************************************/
 void visualize(int _j,unsigned long _seed) {
   int l;
-  printf("pl '-' matrix w image t 'time = %d seed = %ld'\n",_j,_seed);
-  for(l = N-1; l >= 0; l--) {
-    #if(NBINARY==0)
-      if(zealot[l]==1)printf("%d ", spin[l]+1);
-      else printf("%d ", spin[l]);
-    #else
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
+  #if(NBINARY==0)
+    for(l = N-1; l >= 0; l--) {
+      if(zealot[l]==1)cell[N-1-l]=spin[l]+1;
+      else cell[N-1-l]=spin[l];
+    }
+  #endif
+  snprintf(title,sizeof title,"time = %d seed = %ld",_j,_seed);
+  #if(NBINARY==0)
+    vis_emit(title);
+  #else
+    /* the labels (0..N-1) do not fit the byte frame: plain matrix */
+    printf("pl '-' matrix w image t '%s'\n",title);
+    for(l = N-1; l >= 0; l--) {
       if(zealot[l]==1)printf("%d ", -spin[l]);
       else printf("%d ", spin[l]);
-    #endif
-    if( l%L == 0 ) printf("\n");
-  }
-  printf("e\n");
+      if( l%L == 0 ) printf("\n");
+    }
+    printf("e\n");
+  #endif
 }
 
 #ifdef SNAPSHOTS
@@ -359,6 +342,7 @@ void visualize(int _j,unsigned long _seed) {
     int l;
     int identifier = 0;
     char teste[100];
+    uint8_t *frame = malloc(N*sizeof(uint8_t));
 
     lat2eps_init(L,L);
     lat2eps_set_color(0,0x00000); //black
@@ -372,22 +356,33 @@ void visualize(int _j,unsigned long _seed) {
 
     for(l=0; l<N; l++) {
       if(spin[l]==1) {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,4);
-        else lat2eps_set_site(l%L,l/L,6);
+        if(certainty[l]>=1)frame[l]=4;
+        else frame[l]=6;
       }
       else {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,5);
-        else lat2eps_set_site(l%L,l/L,5);
+        if(certainty[l]>=1)frame[l]=5;
+        else frame[l]=5;
       } 
     }
 
-    snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+    #ifdef PNGSNAPS
+      const char *ext = "png";
+    #else
+      const char *ext = "eps";
+    #endif
+    snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     while(exists(teste)==true) {
       identifier++;
-      snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+      snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     }
-    lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #ifdef PNGSNAPS
+      lat2eps_gen_raster(teste,frame,L,L,3,LAT2EPS_PNG);
+    #else
+      lat2eps_set_lattice(frame);
+      lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #endif
     lat2eps_release();
+    free(frame);
   }
 #endif
 
@@ -0,0 +1,1084 @@
+/********************************************************************
+***                     Networks (CSR storage)                    ***
+***                   Last Modified: 19/10/2026                   ***
+***                                                               ***
+***  A network of n nodes is kept as compressed sparse rows: the  ***
+***  neighbours of node i are adj[off[i]] ... adj[off[i+1]-1],    ***
+***  so its degree is off[i+1]-off[i]. Memory is O(n+m), with     ***
+***  m the number of links (each one is stored twice).            ***
+***                                                               ***
+***  Generators, all O(n+m), mean degree kmean:                   ***
+***  net_er(g,n,kmean)   Erdos-Renyi G(n,p), p = kmean/(n-1),     ***
+***                      by geometric skips over the pairs        ***
+***                      (Batagelj & Brandes, PRE 71, 036113)     ***
+***  net_ba(g,n,kmean)   Barabasi-Albert, kmean/2 links per node  ***
+***  net_config(g,n,k)   configuration model of the degrees k[],  ***
+***                      loops and multiple links erased          ***
+***  net_regular(g,n,k)  random k-regular (pairing, then swaps    ***
+***                      of the loops and multiple links)         ***
+***  net_ws(g,n,kmean,beta)  Watts-Strogatz ring, rewiring beta   ***
+***  net_rgg(g,n,kmean)  2D random geometric graph (periodic unit ***
+***                      square), nodes numbered by cell          ***
+***  net_reorder(g,how)  renumbers the nodes for locality of the  ***
+***                      sweep: NET_BFS, NET_RCM (reverse         ***
+***                      Cuthill-McKee) or NET_DEGREE (by degree, ***
+***                      hubs first); g->perm[new] = original id  ***
+***  net_permute(g,a,sz) puts a per node array (original order)   ***
+***                      in the new order                         ***
+***  net_load(g,file,giant)  edge list "a b" per line (ids are    ***
+***                      any integers; '#' or '%' lines skipped,  ***
+***                      a lone id is a node of degree 0), read   ***
+***                      once by chunks in parallel into a binary ***
+***                      CSR cache (file.csr, file.giant.csr with ***
+***                      the giant component only) that later     ***
+***                      runs map read only: no parsing and one   ***
+***                      copy in the page cache for all the jobs  ***
+***  net_free(g)         releases the arrays (or the mapping)     ***
+***                                                               ***
+***  The random numbers come from NET_CHUNKS streams seeded with  ***
+***  the mc.h generator (RANDOM), so the network depends only on  ***
+***  the seed of the run, not on the number of threads. ER, WS    ***
+***  and RGG run the chunks in parallel when compiled with        ***
+***  -fopenmp; BA and the pairings are sequential.                ***
+********************************************************************/
+
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define NET_CHUNKS  64
+
+typedef struct {
+  int n;            /* nodes                                  */
+  long m;           /* links                                  */
+  long *off;        /* n+1 offsets into adj                   */
+  int *adj;         /* 2m neighbours                          */
+  int *perm;        /* original id of each node (NULL: same)  */
+  int64_t *label;   /* id in the edge list of each original   */
+                    /* node (net_load, NULL otherwise)        */
+  void *map;        /* cache mapping holding off, adj, label  */
+  size_t mapsize;
+} network;
+
+typedef struct {
+  long m, room;     /* links, room for links                  */
+  int *a, *b;       /* ends of the links                      */
+} netlist;
+
+#define NET_BFS     1
+#define NET_RCM     2
+#define NET_DEGREE  3
+
+#define NET_DEG(g,i)  ((int)((g)->off[(i)+1]-(g)->off[(i)]))
+
+/********************************************************************
+*                       Random streams                              *
+*                                                                   *
+*  splitmix64; stream c of a generator starts from a base drawn     *
+*  from mc.h, so that chunks can run in any order.                  *
+********************************************************************/
+uint64_t net_base(void)
+{
+  uint64_t hi = RANDOM, lo = RANDOM;
+  return (hi << 32) | lo;
+}
+
+uint64_t net_rand(uint64_t *s)
+{
+  uint64_t z = (*s += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/* uniform in [0,1) */
+double net_uniform(uint64_t *s)
+{
+  return (net_rand(s) >> 11) * (1.0/9007199254740992.0);
+}
+
+uint64_t net_stream(uint64_t base, int c)
+{
+  uint64_t s = base ^ ((uint64_t)(c+1) * 0xD1B54A32D192ED03ull);
+  net_rand(&s);
+  return s;
+}
+
+/********************************************************************
+*                        Lists of links                             *
+********************************************************************/
+__attribute__((noreturn)) void net_nomemory(const char *what)
+{
+  fprintf(stderr,"network: no memory for %s\n",what);
+  exit(1);
+}
+
+void nl_init(netlist *l, long room)
+{
+  l->m = 0;
+  l->room = (room > 16) ? room : 16;
+  l->a = malloc(l->room*sizeof(int));
+  l->b = malloc(l->room*sizeof(int));
+  if (l->a == NULL || l->b == NULL) net_nomemory("the links");
+}
+
+void nl_push(netlist *l, int a, int b)
+{
+  if (l->m == l->room) {
+    l->room *= 2;
+    l->a = realloc(l->a,l->room*sizeof(int));
+    l->b = realloc(l->b,l->room*sizeof(int));
+    if (l->a == NULL || l->b == NULL) net_nomemory("the links");
+  }
+  l->a[l->m] = a;
+  l->b[l->m] = b;
+  l->m++;
+}
+
+/********************************************************************
+*                  CSR from lists of links                          *
+*                                                                   *
+*  The links of the nl lists, in order; the lists are freed.        *
+********************************************************************/
+void net_build(network *g, int n, netlist *l, int nl)
+{
+  long e,m = 0;
+  int i,c;
+
+  for (c = 0; c < nl; c++) m += l[c].m;
+  g->n = n;
+  g->m = m;
+  g->perm = NULL;
+  g->label = NULL;
+  g->map = NULL;
+  g->mapsize = 0;
+  g->off = calloc((size_t)n+1,sizeof(long));
+  g->adj = malloc((size_t)(2*m > 0 ? 2*m : 1)*sizeof(int));
+  if (g->off == NULL || g->adj == NULL) net_nomemory("the network");
+
+  for (c = 0; c < nl; c++)
+    for (e = 0; e < l[c].m; e++) {
+      g->off[l[c].a[e]+1]++;
+      g->off[l[c].b[e]+1]++;
+    }
+  for (i = 0; i < n; i++) g->off[i+1] += g->off[i];
+
+  /* off[i] is used as the next free position of node i and then restored */
+  for (c = 0; c < nl; c++) {
+    for (e = 0; e < l[c].m; e++) {
+      g->adj[g->off[l[c].a[e]]++] = l[c].b[e];
+      g->adj[g->off[l[c].b[e]]++] = l[c].a[e];
+    }
+    free(l[c].a);
+    free(l[c].b);
+  }
+  for (i = n; i > 0; i--) g->off[i] = g->off[i-1];
+  g->off[0] = 0;
+}
+
+/********************************************************************
+*                 Loops and multiple links                          *
+*                                                                   *
+*  net_simplify: sorts the rows and erases loops and repeated       *
+*                neighbours (both ends of a link, so it stays       *
+*                symmetric)                                         *
+********************************************************************/
+int net_cmpint(const void *x, const void *y)
+{
+  int a = *(const int*)x, b = *(const int*)y;
+  return (a > b) - (a < b);
+}
+
+void net_simplify(network *g)
+{
+  long e,f = 0,first;
+  int i;
+
+  for (i = 0; i < g->n; i++) {
+    first = g->off[i];
+    qsort(g->adj+first,g->off[i+1]-first,sizeof(int),net_cmpint);
+    g->off[i] = f;
+    for (e = first; e < g->off[i+1]; e++) {
+      int w = g->adj[e];
+      if (w == i || (f > g->off[i] && g->adj[f-1] == w)) continue;
+      g->adj[f++] = w;
+    }
+  }
+  g->off[g->n] = f;
+  g->m = f/2;
+  g->adj = realloc(g->adj,(size_t)(f > 0 ? f : 1)*sizeof(int));
+}
+
+/********************************************************************
+*                          Erdos-Renyi                              *
+*                                                                   *
+*  The pairs (v,w), w < v, are visited in order and the gap to the  *
+*  next link is geometric: 1 + floor(log(1-r)/log(1-p)).  With      *
+*  p >= 1 every pair is a link. Chunk c takes the rows v from       *
+*  n sqrt(c/C) on, about the same number of pairs for all chunks.   *
+********************************************************************/
+void net_er(network *g, int n, double kmean)
+{
+  double p = (n > 1) ? kmean/(n-1) : 0;
+  double links = p*n*(n-1)/2;
+  uint64_t base = net_base();
+  netlist l[NET_CHUNKS];
+  int c;
+
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1)
+  #endif
+  for (c = 0; c < NET_CHUNKS; c++) {
+    long v = (long)(n*sqrt((double)c/NET_CHUNKS)), vend = (long)(n*sqrt((double)(c+1)/NET_CHUNKS));
+    long w = -1;
+    uint64_t s = net_stream(base,c);
+
+    if (c == NET_CHUNKS-1) vend = n;
+    if (v < 1) v = 1;
+    nl_init(&l[c],(long)((links + 6*sqrt(links))/NET_CHUNKS));
+    while (p > 0 && v < vend) {
+      w += (p >= 1) ? 1 : 1 + (long)floor(log(1-net_uniform(&s))/log(1-p));
+      while (w >= v && v < vend) {
+        w -= v;
+        v++;
+      }
+      if (v < vend) nl_push(&l[c],v,w);
+    }
+  }
+  net_build(g,n,l,NET_CHUNKS);
+}
+
+/********************************************************************
+*                       Barabasi-Albert                             *
+*                                                                   *
+*  m = kmean/2 links per new node, starting from a clique of m+1    *
+*  nodes. A node is chosen with probability proportional to its     *
+*  degree by picking a random end of the links made so far.         *
+********************************************************************/
+void net_ba(network *g, int n, double kmean)
+{
+  int mm = (int)(kmean/2+0.5), v, i, j;
+  uint64_t s = net_stream(net_base(),0);
+  long nends = 0;
+  int *ends,*chosen;
+  netlist l;
+
+  if (mm < 1) mm = 1;
+  if (mm+1 > n) mm = n-1;
+  nl_init(&l,(long)mm*n);
+  ends = malloc((size_t)(2*(long)mm*n+2)*sizeof(int));
+  chosen = malloc((mm+1)*sizeof(int));
+  if (ends == NULL || chosen == NULL) net_nomemory("the links");
+
+  for (v = 1; v <= mm; v++)
+    for (i = 0; i < v; i++) {
+      nl_push(&l,v,i);
+      ends[nends++] = v;
+      ends[nends++] = i;
+    }
+  for (v = mm+1; v < n; v++) {
+    for (i = 0; i < mm; i++) {
+      int t;
+      do {
+        t = ends[(long)(net_uniform(&s)*nends)];
+        for (j = 0; j < i && chosen[j] != t; j++);
+      } while (j < i);
+      chosen[i] = t;
+    }
+    for (i = 0; i < mm; i++) {
+      nl_push(&l,v,chosen[i]);
+      ends[nends++] = v;
+      ends[nends++] = chosen[i];
+    }
+  }
+  free(ends);
+  free(chosen);
+  net_build(g,n,&l,1);
+}
+
+/********************************************************************
+*                     Configuration model                           *
+*                                                                   *
+*  The stubs (k[i] copies of each node i) are shuffled and paired.  *
+*  net_config erases the loops and multiple links (a few links of   *
+*  the hubs are lost); net_regular swaps each of them with a random *
+*  link until none is left, so every node keeps degree k.           *
+********************************************************************/
+void net_pairing(network *g, int n, const int *k, uint64_t *s)
+{
+  long nstubs = 0, e;
+  int *stubs,i,j;
+  netlist l;
+
+  for (i = 0; i < n; i++) nstubs += k[i];
+  if (nstubs%2 == 1) fprintf(stderr,"network: odd sum of degrees, one stub left out\n");
+  stubs = malloc((size_t)(nstubs > 0 ? nstubs : 1)*sizeof(int));
+  if (stubs == NULL) net_nomemory("the stubs");
+  for (i = 0, e = 0; i < n; i++)
+    for (j = 0; j < k[i]; j++) stubs[e++] = i;
+  for (e = nstubs-1; e > 0; e--) {
+    long r = (long)(net_uniform(s)*(e+1));
+    int t = stubs[e];
+    stubs[e] = stubs[r];
+    stubs[r] = t;
+  }
+  nl_init(&l,nstubs/2);
+  for (e = 0; e+1 < nstubs; e += 2) nl_push(&l,stubs[e],stubs[e+1]);
+  free(stubs);
+  net_build(g,n,&l,1);
+}
+
+void net_config(network *g, int n, const int *k)
+{
+  uint64_t s = net_stream(net_base(),0);
+
+  net_pairing(g,n,k,&s);
+  net_simplify(g);
+}
+
+/* position of w in the row of u, -1 if absent */
+long net_find(const network *g, int u, int w)
+{
+  long e;
+  for (e = g->off[u]; e < g->off[u+1]; e++) if (g->adj[e] == w) return e;
+  return -1;
+}
+
+/* a link u-w is bad if it is a loop or if w is also in an earlier position of the row of u */
+int net_bad(const network *g, int u, long e)
+{
+  return (g->adj[e] == u) || (net_find(g,u,g->adj[e]) != e);
+}
+
+void net_regular(network *g, int n, int k)
+{
+  uint64_t s = net_stream(net_base(),0);
+  long e,tries = 0;
+  int *deg,u,i;
+
+  if (((long)n*k)%2 == 1 || k >= n) {
+    fprintf(stderr,"network: no %d-regular network of %d nodes\n",k,n);
+    exit(1);
+  }
+  deg = calloc(n > 0 ? n : 1,sizeof(int));
+  if (deg == NULL) net_nomemory("the degrees");
+  for (i = 0; i < n; i++) deg[i] = k;
+  net_pairing(g,n,deg,&s);
+  free(deg);
+
+  /* u-w and x-y become u-x and w-y */
+  for (u = 0; u < n; u++)
+    for (e = g->off[u]; e < g->off[u+1]; e++) {
+      while (net_bad(g,u,e)) {
+        int w = g->adj[e], x = net_uniform(&s)*n;
+        long f = g->off[x]+(long)(net_uniform(&s)*k);
+        int y = g->adj[f];
+        if (++tries > 1000L*n) {
+          fprintf(stderr,"network: %d-regular network of %d nodes not found\n",k,n);
+          exit(1);
+        }
+        if (x == u || x == w || y == u || y == w || x == y) continue;
+        if (net_find(g,u,x) >= 0 || net_find(g,w,y) >= 0) continue;
+        g->adj[e] = x;
+        g->adj[net_find(g,w,u)] = y;   /* for a loop, the other u of the row */
+        g->adj[f] = u;
+        g->adj[net_find(g,y,x)] = w;
+      }
+    }
+}
+
+/********************************************************************
+*                        Watts-Strogatz                             *
+*                                                                   *
+*  Ring with each node linked to the kmean/2 next ones; the far end *
+*  of each link is moved to a random node with probability beta.    *
+*  The few repeated links made by the rewiring are erased.          *
+********************************************************************/
+void net_ws(network *g, int n, double kmean, double beta)
+{
+  int half = (int)(kmean/2+0.5), c;
+  uint64_t base = net_base();
+  netlist l[NET_CHUNKS];
+
+  if (half >= (n+1)/2) half = (n-1)/2;
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1)
+  #endif
+  for (c = 0; c < NET_CHUNKS; c++) {
+    int i = (long)n*c/NET_CHUNKS, iend = (long)n*(c+1)/NET_CHUNKS, j;
+    uint64_t s = net_stream(base,c);
+
+    nl_init(&l[c],(long)(iend-i)*half);
+    for (; i < iend; i++)
+      for (j = 1; j <= half; j++) {
+        int w = (i+j)%n;
+        if (net_uniform(&s) < beta)
+          do w = net_uniform(&s)*n; while (w == i);
+        nl_push(&l[c],i,w);
+      }
+  }
+  net_build(g,n,l,NET_CHUNKS);
+  net_simplify(g);
+}
+
+/********************************************************************
+*                  Random geometric graph (2D)                      *
+*                                                                   *
+*  n points in the periodic unit square, linked when closer than    *
+*  r = sqrt(kmean/(pi n)). The points are sorted into cells of side *
+*  at least r and numbered cell by cell, so that neighbours have    *
+*  close numbers; each point looks at the 9 cells around its own.   *
+********************************************************************/
+void net_rgg(network *g, int n, double kmean)
+{
+  double r = sqrt(kmean/(M_PI*n)), *x, *y, *px, *py;
+  int side = (int)(1/r), c, i;
+  uint64_t base = net_base();
+  long *start;
+  int *cell;
+  netlist l[NET_CHUNKS];
+
+  if (side < 3) side = 1;
+  x = malloc((size_t)n*sizeof(double));
+  y = malloc((size_t)n*sizeof(double));
+  px = malloc((size_t)n*sizeof(double));
+  py = malloc((size_t)n*sizeof(double));
+  cell = malloc((size_t)n*sizeof(int));
+  start = calloc((size_t)side*side+1,sizeof(long));
+  if (x == NULL || y == NULL || px == NULL || py == NULL || cell == NULL || start == NULL) net_nomemory("the points");
+
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (c = 0; c < NET_CHUNKS; c++) {
+    uint64_t s = net_stream(base,c);
+    int j;
+    for (j = (long)n*c/NET_CHUNKS; j < (long)n*(c+1)/NET_CHUNKS; j++) {
+      x[j] = net_uniform(&s);
+      y[j] = net_uniform(&s);
+      cell[j] = (int)(y[j]*side)*side + (int)(x[j]*side);
+    }
+  }
+
+  /* counting sort of the points by cell */
+  for (i = 0; i < n; i++) start[cell[i]+1]++;
+  for (c = 0; c < side*side; c++) start[c+1] += start[c];
+  for (i = 0; i < n; i++) {
+    long k = start[cell[i]]++;
+    px[k] = x[i];
+    py[k] = y[i];
+  }
+  for (c = side*side; c > 0; c--) start[c] = start[c-1];
+  start[0] = 0;
+  free(x);
+  free(y);
+  free(cell);
+
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1)
+  #endif
+  for (c = 0; c < NET_CHUNKS; c++) {
+    int cy = (long)side*c/NET_CHUNKS, cyend = (long)side*(c+1)/NET_CHUNKS, cx, dx, dy;
+    long a,b;
+
+    nl_init(&l[c],(long)(kmean/2*n/NET_CHUNKS*1.2));
+    for (; cy < cyend; cy++)
+      for (cx = 0; cx < side; cx++)
+        for (a = start[cy*side+cx]; a < start[cy*side+cx+1]; a++)
+          for (dy = (side > 1 ? -1 : 0); dy <= (side > 1 ? 1 : 0); dy++)
+            for (dx = (side > 1 ? -1 : 0); dx <= (side > 1 ? 1 : 0); dx++) {
+              int o = ((cy+dy+side)%side)*side + (cx+dx+side)%side;
+              for (b = start[o]; b < start[o+1]; b++) {
+                double ddx = fabs(px[a]-px[b]), ddy = fabs(py[a]-py[b]);
+                if (b <= a) continue;
+                if (ddx > 0.5) ddx = 1-ddx;
+                if (ddy > 0.5) ddy = 1-ddy;
+                if (ddx*ddx+ddy*ddy < r*r) nl_push(&l[c],a,b);
+              }
+            }
+  }
+  free(px);
+  free(py);
+  free(start);
+  net_build(g,n,l,NET_CHUNKS);
+}
+
+
+/********************************************************************
+*                 Release of off and adj                            *
+*                                                                   *
+*  Freed, or unmapped for a cached network; the labels, also in the *
+*  mapping, are copied out with keep = 1 (and freed by net_free).   *
+********************************************************************/
+void net_release(network *g, int keep)
+{
+  if (g->map != NULL) {
+    int64_t *label = NULL;
+    if (keep && g->label != NULL) {
+      label = malloc((size_t)g->n*sizeof(int64_t));
+      if (label == NULL) net_nomemory("the labels");
+      memcpy(label,g->label,(size_t)g->n*sizeof(int64_t));
+    }
+    munmap(g->map,g->mapsize);
+    g->label = label;
+    g->map = NULL;
+    g->mapsize = 0;
+  }
+  else {
+    free(g->off);
+    free(g->adj);
+  }
+  g->off = NULL;
+  g->adj = NULL;
+}
+
+void net_free(network *g)
+{
+  net_release(g,0);
+  free(g->perm);
+  free(g->label);
+  g->label = NULL;
+  g->off = NULL;
+  g->adj = NULL;
+  g->perm = NULL;
+  g->n = 0;
+  g->m = 0;
+}
+
+/********************************************************************
+*                 Giant component                                   *
+*                                                                   *
+*  Keeps the largest connected component, nodes in the same order. *
+********************************************************************/
+void net_giant(network *g)
+{
+  int n = g->n, *comp = malloc((n > 0 ? n : 1)*sizeof(int));
+  int *queue = malloc((n > 0 ? n : 1)*sizeof(int));
+  int *id, i, nc = 0, best = -1, size, bestsize = 0, k = 0;
+  long e, f = 0;
+
+  if (comp == NULL || queue == NULL) net_nomemory("the components");
+  for (i = 0; i < n; i++) comp[i] = -1;
+  for (i = 0; i < n; i++) {
+    int head = 0, tail = 0;
+    if (comp[i] >= 0) continue;
+    comp[i] = nc;
+    queue[tail++] = i;
+    while (head < tail) {
+      int v = queue[head++];
+      for (e = g->off[v]; e < g->off[v+1]; e++)
+        if (comp[g->adj[e]] < 0) {
+          comp[g->adj[e]] = nc;
+          queue[tail++] = g->adj[e];
+        }
+    }
+    size = tail;
+    if (size > bestsize) {
+      bestsize = size;
+      best = nc;
+    }
+    nc++;
+  }
+
+  /* new ids of the nodes kept (queue is reused) */
+  id = queue;
+  for (i = 0; i < n; i++) id[i] = (comp[i] == best) ? k++ : -1;
+  for (i = 0; i < n; i++) {
+    long first = g->off[i];
+    if (id[i] < 0) continue;
+    g->off[id[i]] = f;
+    for (e = first; e < g->off[i+1]; e++) g->adj[f++] = id[g->adj[e]];
+    if (g->label != NULL) g->label[id[i]] = g->label[i];
+  }
+  g->off[k] = f;
+  g->n = k;
+  g->m = f/2;
+  free(comp);
+  free(id);
+}
+
+/********************************************************************
+*                     Edge list parsing                             *
+*                                                                   *
+*  The text is cut in NET_CHUNKS pieces at line ends; each piece is *
+*  read into pairs of ids (-1: lone node) by its own thread.        *
+********************************************************************/
+typedef struct {
+  long m, room;
+  int64_t *p;       /* a0 b0 a1 b1 ...                        */
+} netpairs;
+
+void np_push(netpairs *l, int64_t a, int64_t b)
+{
+  if (l->m == l->room) {
+    l->room = (l->room > 0) ? 2*l->room : 1024;
+    l->p = realloc(l->p,2*l->room*sizeof(int64_t));
+    if (l->p == NULL) net_nomemory("the edge list");
+  }
+  l->p[2*l->m] = a;
+  l->p[2*l->m+1] = b;
+  l->m++;
+}
+
+void net_parse(const char *text, const char *end, netpairs *l)
+{
+  const char *p = text;
+
+  while (p < end) {
+    int64_t id[2];
+    int k = 0;
+
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    if (p < end && (*p == '#' || *p == '%')) {
+      while (p < end && *p != '\n') p++;
+    }
+    while (p < end && *p != '\n' && k < 2) {
+      if (*p >= '0' && *p <= '9') {
+        int64_t x = 0;
+        while (p < end && *p >= '0' && *p <= '9') x = 10*x + (*p++ - '0');
+        id[k++] = x;
+      }
+      else if (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r') p++;
+      else break;
+    }
+    if (k == 2) np_push(l,id[0],id[1]);
+    else if (k == 1) np_push(l,id[0],-1);
+    while (p < end && *p != '\n') p++;
+    p++;
+  }
+}
+
+int net_cmpid(const void *x, const void *y)
+{
+  int64_t a = *(const int64_t*)x, b = *(const int64_t*)y;
+  return (a > b) - (a < b);
+}
+
+/* position of x in the sorted labels */
+int net_index(const int64_t *label, int n, int64_t x)
+{
+  int lo = 0, hi = n-1;
+  while (lo < hi) {
+    int mid = lo + (hi-lo)/2;
+    if (label[mid] < x) lo = mid+1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+/********************************************************************
+*                     Text edge list to CSR                         *
+*                                                                   *
+*  Nodes are numbered by increasing id of the file; ids up to 8     *
+*  times the number of ends go through a table, others through a    *
+*  sorted list. Loops and multiple links are erased.                *
+********************************************************************/
+int net_read(network *g, const char *fname)
+{
+  netpairs l[NET_CHUNKS];
+  netlist nl[NET_CHUNKS];
+  const char *cut[NET_CHUNKS+1];
+  int64_t *label, max = -1;
+  int *table = NULL, n = 0, c;
+  long e, total = 0;
+  struct stat st;
+  char *text;
+  int fd;
+
+  fd = open(fname,O_RDONLY);
+  if (fd < 0 || fstat(fd,&st) != 0) {
+    if (fd >= 0) close(fd);
+    return 0;
+  }
+  text = (st.st_size > 0) ? mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0) : NULL;
+  close(fd);
+  if (text == MAP_FAILED) return 0;
+
+  cut[0] = text;
+  for (c = 1; c < NET_CHUNKS; c++) {
+    const char *p = text + (long)st.st_size*c/NET_CHUNKS;
+    if (p < cut[c-1]) p = cut[c-1];
+    while (p < text+st.st_size && p > text && p[-1] != '\n') p++;
+    cut[c] = p;
+  }
+  cut[NET_CHUNKS] = text + st.st_size;
+  memset(l,0,sizeof l);
+
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1)
+  #endif
+  for (c = 0; c < NET_CHUNKS; c++) net_parse(cut[c],cut[c+1],&l[c]);
+  if (text != NULL) munmap(text,st.st_size);
+
+  for (c = 0; c < NET_CHUNKS; c++) {
+    total += 2*l[c].m;
+    for (e = 0; e < 2*l[c].m; e++) if (l[c].p[e] > max) max = l[c].p[e];
+  }
+
+  if (max < INT32_MAX && max < 8*total+1024) {
+    table = malloc((size_t)(max+1 > 0 ? max+1 : 1)*sizeof(int));
+    if (table == NULL) net_nomemory("the ids");
+    memset(table,0,(size_t)(max+1)*sizeof(int));
+    for (c = 0; c < NET_CHUNKS; c++)
+      for (e = 0; e < 2*l[c].m; e++) if (l[c].p[e] >= 0) table[l[c].p[e]] = 1;
+    for (e = 0; e <= max; e++) if (table[e]) n++;
+    label = malloc((size_t)(n > 0 ? n : 1)*sizeof(int64_t));
+    if (label == NULL) net_nomemory("the labels");
+    n = 0;
+    for (e = 0; e <= max; e++)
+      if (table[e]) {
+        label[n] = e;
+        table[e] = n++;
+      }
+  }
+  else {
+    long k = 0;
+    label = malloc((size_t)(total > 0 ? total : 1)*sizeof(int64_t));
+    if (label == NULL) net_nomemory("the labels");
+    for (c = 0; c < NET_CHUNKS; c++)
+      for (e = 0; e < 2*l[c].m; e++) if (l[c].p[e] >= 0) label[k++] = l[c].p[e];
+    qsort(label,k,sizeof(int64_t),net_cmpid);
+    for (e = 0; e < k; e++) if (n == 0 || label[e] != label[n-1]) label[n++] = label[e];
+    if (n >= INT32_MAX) {
+      fprintf(stderr,"%s: too many nodes\n",fname);
+      exit(1);
+    }
+  }
+
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic,1)
+  #endif
+  for (c = 0; c < NET_CHUNKS; c++) {
+    long k;
+    nl_init(&nl[c],l[c].m);
+    for (k = 0; k < l[c].m; k++) {
+      int64_t a = l[c].p[2*k], b = l[c].p[2*k+1];
+      if (b < 0) continue;
+      nl_push(&nl[c],table ? table[a] : net_index(label,n,a),table ? table[b] : net_index(label,n,b));
+    }
+    free(l[c].p);
+  }
+  free(table);
+
+  net_build(g,n,nl,NET_CHUNKS);
+  net_simplify(g);
+  g->label = label;
+  return 1;
+}
+
+/********************************************************************
+*                       CSR cache file                              *
+*                                                                   *
+*  header | off (n+1 x 8 bytes) | adj (2m x 4) | label (n x 8).     *
+*  The header has the size and time of the edge list it came from   *
+*  (a newer edge list makes a new cache) and a checksum of itself;  *
+*  the cache is written to a temporary file and renamed, so it is   *
+*  never seen half written.                                         *
+********************************************************************/
+#define NET_MAGIC  "LADCSR1"
+
+typedef struct {
+  char magic[8];
+  uint32_t version, giant;
+  uint64_t n, m;
+  uint64_t srcsize, srcmtime;
+  uint64_t offpos, adjpos, labelpos, size;
+  uint32_t check, pad;
+} netcache;
+
+uint32_t net_fnv(const void *data, size_t len)
+{
+  const unsigned char *p = data;
+  uint32_t h = 2166136261u;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+int net_save(const network *g, const char *cname, const struct stat *src, int giant)
+{
+  char tmp[1100];
+  netcache h;
+  FILE *fp;
+  int ok;
+
+  memset(&h,0,sizeof h);
+  memcpy(h.magic,NET_MAGIC,8);
+  h.version = 1;
+  h.giant = giant;
+  h.n = g->n;
+  h.m = g->m;
+  h.srcsize = src->st_size;
+  h.srcmtime = src->st_mtime;
+  h.offpos = sizeof h;
+  h.adjpos = h.offpos + (h.n+1)*8;
+  h.labelpos = h.adjpos + 2*h.m*4;
+  h.size = h.labelpos + h.n*8;
+  h.check = net_fnv(&h,offsetof(netcache,check));
+
+  snprintf(tmp,sizeof tmp,"%s.tmp%d",cname,(int)getpid());
+  fp = fopen(tmp,"wb");
+  if (fp == NULL) return 0;
+  ok = (fwrite(&h,sizeof h,1,fp) == 1);
+  ok = ok && (fwrite(g->off,8,h.n+1,fp) == h.n+1);
+  ok = ok && (fwrite(g->adj,4,2*h.m,fp) == 2*h.m);
+  ok = ok && (fwrite(g->label,8,h.n,fp) == h.n);
+  ok = ok && (fflush(fp) == 0) && (fsync(fileno(fp)) == 0);
+  ok = (fclose(fp) == 0) && ok;
+  if (!ok || rename(tmp,cname) != 0) {
+    remove(tmp);
+    return 0;
+  }
+  return 1;
+}
+
+/* Return: 1 if the cache is right (and not older than the edge list, if given) */
+int net_map(network *g, const char *cname, const struct stat *src, int giant)
+{
+  struct stat st;
+  netcache *h;
+  void *map;
+  int fd;
+
+  fd = open(cname,O_RDONLY);
+  if (fd < 0) return 0;
+  if (fstat(fd,&st) != 0 || (size_t)st.st_size < sizeof(netcache)) {
+    close(fd);
+    return 0;
+  }
+  map = mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if (map == MAP_FAILED) return 0;
+
+  h = map;
+  if (memcmp(h->magic,NET_MAGIC,8) != 0 || h->version != 1 || (int)h->giant != giant ||
+      h->check != net_fnv(h,offsetof(netcache,check)) || h->size != (uint64_t)st.st_size ||
+      (src != NULL && (h->srcsize != (uint64_t)src->st_size || h->srcmtime != (uint64_t)src->st_mtime))) {
+    munmap(map,st.st_size);
+    return 0;
+  }
+  g->n = h->n;
+  g->m = h->m;
+  g->off = (long*)((char*)map + h->offpos);
+  g->adj = (int*)((char*)map + h->adjpos);
+  g->label = (int64_t*)((char*)map + h->labelpos);
+  g->perm = NULL;
+  g->map = map;
+  g->mapsize = st.st_size;
+  return 1;
+}
+
+/********************************************************************
+*                       Empirical network                           *
+*                                                                   *
+*  Maps the cache of "fname" or, if there is none yet (or the edge  *
+*  list changed), reads the edge list and writes it. Concurrent     *
+*  jobs wait on a lock (cache.lock) for the one that reads it.      *
+*  A cache alone, without its edge list, is used as it is.          *
+*  Return: 1 on success                                             *
+********************************************************************/
+int net_load(network *g, const char *fname, int giant)
+{
+  char cname[1024],lname[1100];
+  struct stat src;
+  int fd, hassrc, ok;
+
+  snprintf(cname,sizeof cname,"%s%s",fname,giant ? ".giant.csr" : ".csr");
+  hassrc = (stat(fname,&src) == 0);
+  if (net_map(g,cname,hassrc ? &src : NULL,giant)) return 1;
+  if (!hassrc) return 0;
+
+  snprintf(lname,sizeof lname,"%s.lock",cname);
+  fd = open(lname,O_CREAT|O_RDWR,0644);
+  if (fd >= 0) flock(fd,LOCK_EX);
+  ok = net_map(g,cname,&src,giant);
+  if (!ok && net_read(g,fname)) {
+    if (giant) net_giant(g);
+    ok = 1;
+    if (net_save(g,cname,&src,giant)) {
+      network mapped;
+      if (net_map(&mapped,cname,&src,giant)) {
+        net_free(g);
+        *g = mapped;
+      }
+    }
+    else fprintf(stderr,"%s: cache can not be written, edge list read again next time\n",cname);
+  }
+  if (fd >= 0) {
+    flock(fd,LOCK_UN);
+    close(fd);
+  }
+  return ok;
+}
+
+/********************************************************************
+*                        Reordering                                 *
+*                                                                   *
+*  The sweep reads spin[] and certainty[] of a random neighbour:    *
+*  with the nodes numbered so that neighbours have close numbers    *
+*  most of those reads hit the cache. BFS and RCM number the nodes  *
+*  of each component in breadth first order from a node of least    *
+*  degree (RCM: neighbours by increasing degree, whole order        *
+*  reversed); NET_DEGREE sorts by decreasing degree, so the hubs,   *
+*  read the most, share a few cache lines.                          *
+*  The rows are sorted after the renumbering.                       *
+********************************************************************/
+/* nodes sorted by degree (counting sort), increasing or decreasing */
+void net_bydegree(const network *g, int decreasing, int *order)
+{
+  int n = g->n, kmax = 0, i, k;
+  long *count;
+
+  for (i = 0; i < n; i++) if (NET_DEG(g,i) > kmax) kmax = NET_DEG(g,i);
+  count = calloc((size_t)kmax+2,sizeof(long));
+  for (i = 0; i < n; i++) {
+    k = decreasing ? kmax-NET_DEG(g,i) : NET_DEG(g,i);
+    count[k+1]++;
+  }
+  for (k = 0; k <= kmax; k++) count[k+1] += count[k];
+  for (i = 0; i < n; i++) {
+    k = decreasing ? kmax-NET_DEG(g,i) : NET_DEG(g,i);
+    order[count[k]++] = i;
+  }
+  free(count);
+}
+
+void net_order(const network *g, int how, int *order)
+{
+  int n = g->n, head = 0, tail = 0, kmax = 0, i, j, k;
+  int *start,*tmp = NULL;
+  long *count = NULL;
+  char *seen;
+  long e;
+
+  if (how == NET_DEGREE) {
+    net_bydegree(g,1,order);
+    return;
+  }
+
+  /* the first node of each component is one of least degree */
+  start = malloc((n > 0 ? n : 1)*sizeof(int));
+  seen = calloc(n > 0 ? n : 1,1);
+  if (start == NULL || seen == NULL) net_nomemory("the ordering");
+  net_bydegree(g,0,start);
+  if (how == NET_RCM) {
+    for (i = 0; i < n; i++) if (NET_DEG(g,i) > kmax) kmax = NET_DEG(g,i);
+    tmp = malloc((n > 0 ? n : 1)*sizeof(int));
+    count = calloc((size_t)kmax+2,sizeof(long));
+    if (tmp == NULL || count == NULL) net_nomemory("the ordering");
+  }
+
+  for (k = 0; k < n; k++) {
+    if (seen[start[k]]) continue;
+    seen[start[k]] = 1;
+    order[tail++] = start[k];
+    while (head < tail) {
+      int v = order[head++], first = tail;
+      for (e = g->off[v]; e < g->off[v+1]; e++) {
+        int w = g->adj[e];
+        if (seen[w]) continue;
+        seen[w] = 1;
+        order[tail++] = w;
+      }
+      /* RCM: the new ones by degree, a stable counting sort over
+         0..dmax, dmax the largest degree among them; as every node
+         is new once, the counts cost O(n+m) in all */
+      if (how == NET_RCM && tail-first > 1) {
+        int dmax = 0;
+        for (i = first; i < tail; i++) if (NET_DEG(g,order[i]) > dmax) dmax = NET_DEG(g,order[i]);
+        for (i = first; i < tail; i++) count[NET_DEG(g,order[i])+1]++;
+        for (k = 0; k < dmax; k++) count[k+1] += count[k];
+        for (i = first; i < tail; i++) tmp[first+count[NET_DEG(g,order[i])]++] = order[i];
+        memcpy(order+first,tmp+first,(size_t)(tail-first)*sizeof(int));
+        memset(count,0,((size_t)dmax+2)*sizeof(long));
+      }
+    }
+  }
+  if (how == NET_RCM)
+    for (i = 0, j = n-1; i < j; i++, j--) {
+      k = order[i];
+      order[i] = order[j];
+      order[j] = k;
+    }
+
+  free(start);
+  free(seen);
+  free(tmp);
+  free(count);
+}
+
+void net_reorder(network *g, int how)
+{
+  int n = g->n, i;
+  int *order = malloc((n > 0 ? n : 1)*sizeof(int));
+  int *inv = malloc((n > 0 ? n : 1)*sizeof(int));
+  long *off = malloc(((size_t)n+1)*sizeof(long));
+  long *next = malloc(((size_t)n+1)*sizeof(long));
+  int *adj = malloc((size_t)(2*g->m > 0 ? 2*g->m : 1)*sizeof(int));
+  long e;
+
+  if (order == NULL || inv == NULL || off == NULL || next == NULL || adj == NULL) {
+    fprintf(stderr,"network: no memory to reorder %d nodes\n",n);
+    exit(1);
+  }
+  net_order(g,how,order);
+  for (i = 0; i < n; i++) inv[order[i]] = i;
+
+  off[0] = 0;
+  for (i = 0; i < n; i++) off[i+1] = off[i] + NET_DEG(g,order[i]);
+  memcpy(next,off,((size_t)n+1)*sizeof(long));
+
+  /* the rows are symmetric: node i goes into the rows of its
+     neighbours for i = 0,1,..., so every row comes out sorted */
+  for (i = 0; i < n; i++) {
+    int o = order[i];
+    for (e = g->off[o]; e < g->off[o+1]; e++) adj[next[inv[g->adj[e]]]++] = i;
+  }
+  free(next);
+
+  /* a second reordering composes with the first one */
+  if (g->perm != NULL) {
+    for (i = 0; i < n; i++) inv[i] = g->perm[order[i]];
+    for (i = 0; i < n; i++) order[i] = inv[i];
+    free(g->perm);
+  }
+  free(inv);
+  net_release(g,1);
+  g->off = off;
+  g->adj = adj;
+  g->perm = order;
+}
+
+/* array of n elements of "size" bytes, in the original order, into the new one */
+void net_permute(const network *g, void *a, size_t size)
+{
+  char *tmp,*p = a;
+  int i;
+
+  if (g->perm == NULL) return;
+  tmp = malloc((size_t)g->n*size);
+  if (tmp == NULL) {
+    fprintf(stderr,"network: no memory to permute\n");
+    exit(1);
+  }
+  for (i = 0; i < g->n; i++) memcpy(tmp+(size_t)i*size,p+(size_t)g->perm[i]*size,size);
+  memcpy(p,tmp,(size_t)g->n*size);
+  free(tmp);
+}
+
+#endif
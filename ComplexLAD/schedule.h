@@ -0,0 +1,131 @@
+/********************************************************************
+***                    Measurement Schedules                      ***
+***                   Last Modified: 19/10/2026                   ***
+***                                                               ***
+***  The times of the measurements are generated when asked for,  ***
+***  in place of a table of MCS entries: sched_time(s,k) is the   ***
+***  time of the k-th measurement (k = 0, 1, ...) and 0 once the  ***
+***  schedule is over, as in the old zero-terminated tables.      ***
+***  Sequential k costs O(1) and the schedule is a few words.     ***
+***                                                               ***
+***  sched_decades(s,tmax)      0,1,...,9,10,20,...,90,100,...    ***
+***                             (measures1, time_table_decades)   ***
+***  sched_log(s,tmax,count)    count times log spaced up to tmax ***
+***                             (measures2)                       ***
+***  sched_linear(s,tmax,count) count times from 0 to tmax        ***
+***  sched_event(s,level)       not a time table: sched_cross()   ***
+***                             is 1 when a quantity (activesum,  ***
+***                             qt[0], ...) crosses "level"       ***
+********************************************************************/
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <math.h>
+
+#define SCHED_DECADES  0
+#define SCHED_LOG      1
+#define SCHED_LINEAR   2
+#define SCHED_EVENT    3
+
+typedef struct {
+  int type;
+  int tmax;         /* last time                              */
+  int count;        /* number of times (log, linear)          */
+  double ratio;     /* ratio between log spaced times         */
+  int k, t;         /* last time generated (k = -1: none)     */
+  double level;     /* event level                            */
+  int side;         /* side of the level (event), 0 = unknown */
+} schedule;
+
+/********************************************************************
+*                          Schedules                                *
+********************************************************************/
+void sched_decades(schedule *s, int tmax)
+{
+  s->type = SCHED_DECADES;
+  s->tmax = tmax;
+  s->count = 0;
+  s->k = -1;
+  s->t = 0;
+}
+
+void sched_log(schedule *s, int tmax, int count)
+{
+  s->type = SCHED_LOG;
+  s->tmax = tmax;
+  s->count = count;
+  s->ratio = pow((double)tmax,1.0/(count-1));
+  s->k = -1;
+  s->t = 0;
+}
+
+void sched_linear(schedule *s, int tmax, int count)
+{
+  s->type = SCHED_LINEAR;
+  s->tmax = tmax;
+  s->count = count;
+  s->k = -1;
+  s->t = 0;
+}
+
+void sched_event(schedule *s, double level)
+{
+  s->type = SCHED_EVENT;
+  s->level = level;
+  s->side = 0;
+}
+
+/********************************************************************
+*                        k-th time                                  *
+*                                                                   *
+*  Log and linear times are made strictly increasing (each one at   *
+*  least the previous plus 1), as measures2() did, so they are      *
+*  generated in order from the last one asked for.                  *
+********************************************************************/
+int sched_time(schedule *s, int k)
+{
+  long p = 1;
+  int t;
+
+  if (k < 0) return 0;
+
+  if (s->type == SCHED_DECADES) {
+    if (k == 0) return 0;
+    for (t = (k-1)/9; t > 0 && p <= s->tmax; t--) p *= 10;
+    p *= (k-1)%9 + 1;
+    return (p <= s->tmax) ? (int)p : 0;
+  }
+
+  if (s->type == SCHED_EVENT || k >= s->count) return 0;
+
+  if (k < s->k) {
+    s->k = -1;
+    s->t = 0;
+  }
+  while (s->k < k) {
+    s->k++;
+    if (s->type == SCHED_LOG) t = (int)pow(s->ratio,(double)s->k);
+    else t = (s->count > 1) ? (int)((double)s->k*s->tmax/(s->count-1)) : 0;
+    if (s->k > 0 && t <= s->t) t = s->t+1;
+    s->t = t;
+  }
+  return s->t;
+}
+
+/********************************************************************
+*                           Events                                  *
+*                                                                   *
+*  Return: 1 if "value" is on the other side of the level than in   *
+*          the previous call (the first call only sets the side)    *
+********************************************************************/
+int sched_cross(schedule *s, double value)
+{
+  int side = (value >= s->level) ? 1 : -1;
+  int crossed = (s->side != 0 && side != s->side);
+
+  s->side = side;
+  return crossed;
+}
+
+#endif
@@ -14,7 +14,17 @@
  **************************************************************/
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DPNGSNAPS [with SNAPSHOTS, PNG snapshots instead of EPS]
+// -DNETWORK=0|1|2|3|4|5|6 [with COMPLEX: Erdos-Renyi, Barabasi-Albert, configuration model, random regular, Watts-Strogatz, 2D random geometric, edge list file (see network.h)]
+// -DGIANT [with NETWORK=6, giant component only]
+// -DKMEAN=4 [with COMPLEX, mean degree, also given at run time: ./a.out 6.0 (NETWORK=2: ./a.out degrees.dat, one degree per line; NETWORK=6: ./a.out edges.txt, N from the file, kept in edges.txt.csr for the next runs)]
+// -DBETA=0.1 [with NETWORK=4, rewiring probability]
+// -fopenmp [with COMPLEX, network generated in parallel; same network for any number of threads]
+// -DLINKUPDATE [with COMPLEX, link update dynamics in continuous time, drawing only discordant links (see linksweep)]
+// -DREORDER=1|2|3 [with COMPLEX, renumber the nodes by BFS, RCM or degree for cache locality (see network.h)]
+// -DMEANFIELD [with COMPLEX, complete graph of N nodes kept as counts of agents per class, no network and no arrays of size N (see mean field sweep)]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -31,22 +41,36 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
+#include "network.h"
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
  ***************************************************************/
 #if(COMPLEX==0)
     #define N          (L*L)  //Lattice volume  
+#elif(NETWORK==6 && MEANFIELD==0)
+    #define N          (net.n)  //Nodes of the edge list
 #endif
 #define MCS         1E6 //Max evolution time
 #define THRESHOLD   1. //Certainty's treshold
 #define MEASURES    40
+#ifndef KMEAN
+    #define KMEAN      4 //Mean degree of the network
+#endif
+#ifndef BETA
+    #define BETA       0.1 //Rewiring probability (Watts-Strogatz)
+#endif
+#ifndef NETWORK
+    #define NETWORK    0 //Erdos-Renyi
+#endif
 
 /****************************************************************
  *                            SETTINGS 
  ***************************************************************/
 
-#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 #define SIMPLIFIED  1 // 1 --> simplify the algorithm to alpha=beta=1 to avoid calculations
 
 /***************************************************************
@@ -64,10 +88,27 @@ void sweep(void);
 #endif
 void states(void); 
 void structure2dlattice(void);
-void structurecomplexER(void);
-void measures1(void); 
-void measures2(void);
+void structurecomplex(void);
 void hoshen_kopelman(void);
+void clusters(void);
+int discordant(int);
+int root(int);
+void activelinks(void);
+#if(MEANFIELD==1)
+  void mfinit(void);
+  void mfadd(int,long);
+  int mfpick(long);
+#elif(LINKUPDATE==1)
+  void linkinit(void);
+  void linkflip(int);
+  void linkadd(long);
+  void linkremove(long);
+  int cmplink(const void *, const void *);
+  void settle(long,double);
+  double addeta(double,long);
+  void bring(int,double);
+  long poisson(double);
+#endif
 int biasedwalk(int qual, int *lab);
 int delta(int i, int j, int hh);
 void connections(int,int);
@@ -80,11 +121,25 @@ bool probcheck(double);
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,*memory,*measures,*zealot, sum, sumz, activesum;
+int *spin,*memory,*zealot, sum, sumz;
+long activesum;
+schedule measures;
 #if(COMPLEX==0)
 int **neigh,*right,*left,*up, *down;
 #else
-int **links,**matrix,*kn;
+network net;
+double kmean = KMEAN;
+const char *degfile = "degrees.dat";
+const char *edgefile = "edges.txt";
+const char *netname[] = {"ER","BA","CM","RR","WS","RGG","FILE"};
+#if(MEANFIELD==1)
+long *cnt,*fen;
+int nlev,zlev,ncls,fenbit;
+#elif(LINKUPDATE==1)
+long *twin,*dset,*dpos,dsize;
+int *src;
+double *tlink,tnow;
+#endif
 #endif
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2;
 int probperc0,probperc1;
@@ -96,7 +151,18 @@ double *certainty;
 /***************************************************************
  *                          MAIN PROGRAM  
  **************************************************************/
-int main(void){
+int main(int argc, char *argv[]){
+
+  #if(COMPLEX==1 && MEANFIELD==0)
+    #if(NETWORK==2)
+      if(argc>1)degfile = argv[1];
+    #elif(NETWORK==6)
+      if(argc>1)edgefile = argv[1];
+      structurecomplex();
+    #else
+      if(argc>1)kmean = atof(argv[1]);
+    #endif
+  #endif
 
   #if(DEBUG==0)
     #if(SEED==0)
@@ -132,22 +198,23 @@ int main(void){
           fprintf(fp1,"%d %.8f %.8f %.8f %d\n",j,(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0]);
           fflush(fp1);
         #else
-          fprintf(fp1,"%d %.8f %.8f %.8f %d\n",measures[k],(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0]);
+          clusters();
+          fprintf(fp1,"%d %.8f %.8f %.8f %d %.8f %.8f %.8f\n",sched_time(&measures,k),(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0],(double)numc/N,(double)mx1/N,(double)mx2/N);
           fflush(fp1);
         #endif
-        while(measures[k]!=0){
+        while(sched_time(&measures,k)!=0){
           #if(COMPLEX==0)
-            fprintf(fp1,"%d %.8f %.8f %.8f %d\n",measures[k],(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0]);
+            fprintf(fp1,"%d %.8f %.8f %.8f %d\n",sched_time(&measures,k),(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0]);
             fflush(fp1);
           #else
-            fprintf(fp1,"%d %.8f %.8f %.8f %d\n",measures[k],(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0]);
+            fprintf(fp1,"%d %.8f %.8f %.8f %d %.8f %.8f %.8f\n",sched_time(&measures,k),(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0],(double)numc/N,(double)mx1/N,(double)mx2/N);
             fflush(fp1);
           #endif
           k++;
         }           
         break;
       }
-      if (measures[k]==j) {  
+      if (sched_time(&measures,k)==j) {  
         #if(SNAPSHOTS==1)
           snap();   
           k++;        
@@ -158,7 +225,8 @@ int main(void){
             fprintf(fp1,"%d %.8f %.8f %.8f %d\n",j,(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0]);
             fflush(fp1);
           #else
-            fprintf(fp1,"%d %.8f %.8f %.8f %d\n",measures[k],(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0]);
+            clusters();
+            fprintf(fp1,"%d %.8f %.8f %.8f %d %.8f %.8f %.8f\n",sched_time(&measures,k),(double)sum/N,(double)sumz/N,(double)activesum/N,qt[0],(double)numc/N,(double)mx1/N,(double)mx2/N);
             fflush(fp1);
           #endif
           k++;
@@ -173,6 +241,17 @@ int main(void){
   #endif
 
 }
+
+/* n increments of DETA, one at a time up to THRESHOLD as the draws
+   would add them (ten 0.1 make 0.9999999999999999, not 1), the rest
+   at once */
+double addeta(double c, long n) {
+  while(n>0 && c<THRESHOLD){
+    c += DETA;
+    n--;
+  }
+  return c + n*DETA;
+}
 /***************************************************************
  *                        INICIALIZAÇÃO  
  **************************************************************/
@@ -180,12 +259,16 @@ void initialize(void) {
  
   start_randomic(seed);
 
+  #if(MEANFIELD==1)
+    qt = calloc(2,sizeof(int));
+    mfinit();
+  #else
   his = malloc(N*sizeof(int));
   spin = malloc(N*sizeof(int));
   memory = malloc(N*sizeof(int));
   zealot = malloc(N*sizeof(int));
   certainty = malloc(N*sizeof(double));
-  qt = malloc(2*sizeof(int));
+  qt = calloc(2,sizeof(int));
 
   for(int n=0; n<N; n++) { 
     certainty[n] = 0;
@@ -199,14 +282,26 @@ void initialize(void) {
   #if(COMPLEX==0)
     structure2dlattice();
   #else
-    structurecomplexER();
+    #if(NETWORK!=6)
+      structurecomplex();
+    #endif
+    #if(REORDER>0)
+      net_reorder(&net,REORDER);
+      net_permute(&net,spin,sizeof(int));
+    #endif
+    activelinks();
+    #if(LINKUPDATE==1)
+      linkinit();
+    #endif
+  #endif
   #endif
 
-  measures = malloc(MCS*sizeof(int));
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 
 }
@@ -243,36 +338,44 @@ void structure2dlattice(void){
  *               MCS routine
  ***************************************************************/
 
-void structurecomplexER(void){
-  links = (int**)malloc(N*sizeof(int*));
-  matrix = (int**)malloc(N*sizeof(int*));
-  kn = malloc(N*sizeof(int*));
-  for(int n=0; n<N; n++){
-    matrix[n] = (int*)malloc(N*sizeof(int));
-  }
-  for(int n=0; n<N; n++){
-    for(int l = n+1; l<N; l++){
-      double ALPHA = (double)(4)/(N-1);
-      bool R = probcheck(ALPHA);
-      if(R==true){
-        matrix[n][l]=1;
-        matrix[l][n]=1;
-        kn[n]++;
-        kn[l]++;
-      }
+void structurecomplex(void){
+  #if(NETWORK==1)
+    net_ba(&net,N,kmean);
+  #elif(NETWORK==2)
+    FILE *fp = fopen(degfile,"r");
+    int *k = malloc(N*sizeof(int));
+    if(fp==NULL){
+      fprintf(stderr,"%s: can not be read\n",degfile);
+      exit(1);
     }
-  }
-  for(int n=0; n<N; n++){
-    int k=0;
-    links[n] = (int*)malloc(kn[n]*sizeof(int));
-    for(int l=0; l<N; l++){
-      if(matrix[n][l]==1){
-        links[n][k]=l;
-        k++;
+    for(int n=0; n<N; n++){
+      if(fscanf(fp,"%d",&k[n])!=1){
+        fprintf(stderr,"%s: less than %d degrees\n",degfile,N);
+        exit(1);
       }
     }
-  }
-  free(matrix);
+    fclose(fp);
+    net_config(&net,N,k);
+    free(k);
+  #elif(NETWORK==3)
+    net_regular(&net,N,(int)(kmean+0.5));
+  #elif(NETWORK==4)
+    net_ws(&net,N,kmean,BETA);
+  #elif(NETWORK==5)
+    net_rgg(&net,N,kmean);
+  #elif(NETWORK==6)
+    int giant = 0;
+    #ifdef GIANT
+      giant = 1;
+    #endif
+    if(net_load(&net,edgefile,giant)==0){
+      fprintf(stderr,"%s: can not be read\n",edgefile);
+      exit(1);
+    }
+    kmean = (N>0) ? 2.*net.m/N : 0;
+  #else
+    net_er(&net,N,kmean);
+  #endif
 }
 
 #if(COMPLEX==0)
@@ -307,6 +410,271 @@ void sweep(void) {
     }
   }
 }
+#elif(MEANFIELD==1)
+/****************************************************************
+ *               Mean field: complete graph by counts
+ *
+ *  On the complete graph an agent is known by its class only:
+ *  opinion, memory (ever flipped, for the persistence) and the
+ *  number of DETA received since the last reset. After zlev
+ *  increments it is a zealot and more of them change nothing,
+ *  so the levels stop at zlev: 4(zlev+1) classes whatever N.
+ *  cnt[] holds the agents per class and fen[] their partial
+ *  sums (Fenwick tree), so an agent is drawn with one random
+ *  number and O(log classes) steps. The neighbour is drawn
+ *  from the other N-1 agents (node taken out of its class).
+ ***************************************************************/
+void mfinit(void) {
+  double c=0;
+
+  zlev=0;
+  if(DETA>0){
+    while(c<THRESHOLD){  // the same sum as certainty[] += DETA
+      c += DETA;
+      zlev++;
+    }
+  }
+  nlev = (DETA>0) ? zlev+1 : 1;
+  if(DETA<=0)zlev = 1;
+  ncls = 4*nlev;
+  for(fenbit=1; 2*fenbit<=ncls; fenbit*=2);
+  cnt = calloc(ncls,sizeof(long));
+  fen = calloc(ncls+1,sizeof(long));
+  if(cnt==NULL || fen==NULL){
+    fprintf(stderr,"mfinit: out of memory (%d classes)\n",ncls);
+    exit(1);
+  }
+
+  for(int n=0; n<N; n++) {
+    int k=FRANDOM*2;
+    qt[k]++;
+  }
+  mfadd(0,qt[0]);
+  mfadd(2*nlev,qt[1]);
+}
+
+/* d agents more in class c */
+void mfadd(int c, long d) {
+  cnt[c] += d;
+  for(int i=c+1; i<=ncls; i+=i&(-i))fen[i] += d;
+}
+
+/* class of the r-th agent, 0 <= r < agents in the tree */
+int mfpick(long r) {
+  int c=0;
+  for(int b=fenbit; b>0; b/=2){
+    if(c+b<=ncls && fen[c+b]<=r){
+      c += b;
+      r -= fen[c];
+    }
+  }
+  return c;
+}
+
+void sweep(void) {
+
+  if(N<2)return;
+  for (int n=0; n<N; n++) {
+    int node = mfpick((long)(FRANDOM*N));
+    mfadd(node,-1);
+    int neighbour = mfpick((long)(FRANDOM*(N-1)));
+    int s = node/(2*nlev), mem = (node/nlev)%2, eta = node%nlev;
+    if(s!=neighbour/(2*nlev)) {
+      if(eta < zlev){
+        qt[s]--;
+        s = 1-s;
+        qt[s]++;
+        mem = 1;
+      }
+      eta = 0;
+    }
+    else if(eta<nlev-1)eta++;
+    mfadd((2*s+mem)*nlev+eta,1);
+    if(neighbour%nlev<nlev-1){
+      mfadd(neighbour,-1);
+      mfadd(neighbour+1,1);
+    }
+  }
+}
+#elif(LINKUPDATE==1)
+/****************************************************************
+ *               Link update in continuous time
+ *
+ *  Each elementary step draws one of the 2m (directed) links;
+ *  N steps make one MCS. Only the discordant ones, kept in
+ *  dset (2 x activesum directed links, O(1) insertion and
+ *  removal by swap with the last), change spins, so the time
+ *  goes from discordant event to discordant event with rate
+ *  N dsize/(2m), exponential gaps.
+ *  A concordant link adds DETA to both ends at once, at rate
+ *  N/m. Each link keeps the time tlink[] up to which its
+ *  increments were given to its ends; settle() draws the
+ *  Poisson number of them since then. bring() settles all the
+ *  links of a node: before its certainty is reset (which also
+ *  decides if it was a zealot) and for all nodes before a
+ *  measurement. A link that turns concordant starts at tnow.
+ *  As the certainty only grows between resets, the DETA from a
+ *  discordant link can be added before the pending ones and
+ *  zealot[] (certainty >= THRESHOLD) is right once they are.
+ ***************************************************************/
+void sweep(void) {
+  double tend = tnow+1;
+
+  while(dsize>0){
+    double dt = -log(1-FRANDOM)*2.*net.m/((double)N*dsize);
+    if(tnow+dt>tend)break;
+    tnow += dt;
+    long e = dset[(long)(FRANDOM*dsize)];
+    int node = src[e];
+    int neighbour = net.adj[e];
+    bring(node,tnow);
+    if(zealot[node] == 0){
+      memory[node]=1;
+      qt[(spin[node] + 1 )/2]--;
+      spin[node] = spin[neighbour];
+      qt[(spin[neighbour] + 1 )/2]++;
+      linkflip(node);
+    }
+    certainty[neighbour] += DETA;
+    certainty[node] = 0;
+    if(certainty[node]<=THRESHOLD)zealot[node]=0;
+    if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+  }
+  tnow = tend;
+}
+
+/* increments of the concordant link e up to time t, to both ends */
+void settle(long e, double t) {
+  long k = (e<twin[e]) ? e : twin[e];
+  if(t<=tlink[k])return;
+  long n = poisson((t-tlink[k])*N/net.m);
+  tlink[k] = t;
+  if(n>0){
+    int i = src[e], w = net.adj[e];
+    certainty[i] = addeta(certainty[i],n);
+    certainty[w] = addeta(certainty[w],n);
+    if(certainty[i]>=THRESHOLD)zealot[i]=1;
+    if(certainty[w]>=THRESHOLD)zealot[w]=1;
+  }
+}
+
+/* certainty of node i brought to time t */
+void bring(int i, double t) {
+  for(long e=net.off[i]; e<net.off[i+1]; e++){
+    if(dpos[e]<0)settle(e,t);
+  }
+}
+
+/* node has flipped (brought to tnow before): its links change side */
+void linkflip(int node) {
+  for(long e=net.off[node]; e<net.off[node+1]; e++){
+    int w = net.adj[e];
+    if(spin[w]!=spin[node]){
+      linkadd(e);
+      linkadd(twin[e]);
+    }
+    else {
+      linkremove(e);
+      linkremove(twin[e]);
+      tlink[(e<twin[e]) ? e : twin[e]] = tnow;
+    }
+  }
+  activesum = dsize/2;
+}
+
+void linkadd(long e) {
+  dpos[e] = dsize;
+  dset[dsize++] = e;
+}
+
+void linkremove(long e) {
+  long last = dset[--dsize];
+  dset[dpos[e]] = last;
+  dpos[last] = dpos[e];
+  dpos[e] = -1;
+}
+
+/****************************************************************
+ *               Link update setup
+ *
+ *  src[e]: node whose row holds the directed link e.
+ *  twin[e]: the same link seen from the other end, found by
+ *  sorting the directed links by their pair of ends (simple
+ *  networks: each pair appears twice).
+ ***************************************************************/
+int cmplink(const void *x, const void *y) {
+  const long *a = x, *b = y;
+  if(a[0]!=b[0])return (a[0]>b[0]) - (a[0]<b[0]);
+  return (a[1]>b[1]) - (a[1]<b[1]);
+}
+
+void linkinit(void) {
+  long nl = 2*net.m;
+  long *pairs = malloc(2*(nl>0?nl:1)*sizeof(long));
+
+  twin = malloc((nl>0?nl:1)*sizeof(long));
+  dset = malloc((nl>0?nl:1)*sizeof(long));
+  dpos = malloc((nl>0?nl:1)*sizeof(long));
+  src = malloc((nl>0?nl:1)*sizeof(int));
+  tlink = calloc((nl>0?nl:1),sizeof(double));
+  if(pairs==NULL || twin==NULL || dset==NULL || dpos==NULL || src==NULL || tlink==NULL){
+    fprintf(stderr,"no memory for the link update\n");
+    exit(1);
+  }
+
+  for(int i=0; i<N; i++){
+    for(long e=net.off[i]; e<net.off[i+1]; e++){
+      int w = net.adj[e];
+      pairs[2*e] = (i<w) ? ((long)i<<32)|w : ((long)w<<32)|i;
+      pairs[2*e+1] = e;
+      src[e] = i;
+    }
+  }
+  qsort(pairs,nl,2*sizeof(long),cmplink);
+  for(long e=0; e+1<nl; e+=2){
+    twin[pairs[2*e+1]] = pairs[2*e+3];
+    twin[pairs[2*e+3]] = pairs[2*e+1];
+  }
+  free(pairs);
+
+  dsize = 0;
+  tnow = 0;
+  for(int i=0; i<N; i++){
+    for(long e=net.off[i]; e<net.off[i+1]; e++){
+      dpos[e] = -1;
+      if(spin[net.adj[e]]!=spin[i])linkadd(e);
+    }
+  }
+}
+
+/****************************************************************
+ *               Poisson numbers
+ *
+ *  Inversion for small means, transformed rejection (PTRS,
+ *  Hormann 1993) for the others.
+ ***************************************************************/
+long poisson(double mu) {
+  if(mu<10){
+    double p = exp(-mu), f = p, u = FRANDOM;
+    long n = 0;
+    while(u>f && n<1000){
+      n++;
+      p *= mu/n;
+      f += p;
+    }
+    return n;
+  }
+  double slam = sqrt(mu), loglam = log(mu);
+  double b = 0.931 + 2.53*slam, a = -0.059 + 0.02483*b;
+  double invalpha = 1.1239 + 1.1328/(b-3.4), vr = 0.9277 - 3.6224/(b-2);
+  for(;;){
+    double u = FRANDOM-0.5, v = FRANDOM, us = 0.5-fabs(u);
+    long k = (long)floor((2*a/us + b)*u + mu + 0.43);
+    if(us>=0.07 && v<=vr)return k;
+    if(k<0 || (us<0.013 && v>us))continue;
+    if(log(v) + log(invalpha) - log(a/(us*us)+b) <= -mu + k*loglam - lgamma(k+1))return k;
+  }
+}
 #else
 /****************************************************************
  *               MCS routine
@@ -315,14 +683,16 @@ void sweep(void) {
 
   for (int n=0; n<N; n++) {
     int node = FRANDOM*N;
-    int edge = FRANDOM*kn[node];
-    int neighbour = links[node][edge];
+    int kn = NET_DEG(&net,node);
+    if(kn==0)continue;
+    int neighbour = net.adj[net.off[node]+(int)(FRANDOM*kn)];
     if(spin[node]!=spin[neighbour]) {
       if(zealot[node] == 0){
         memory[node]=1;
         qt[(spin[node] + 1 )/2]--;
         spin[node] = spin[neighbour];
         qt[(spin[neighbour] + 1 )/2]++;
+        activesum += 2*discordant(node) - kn;
       }
       certainty[neighbour] += DETA;
       certainty[node] = 0;
@@ -344,53 +714,128 @@ void sweep(void) {
  *               Check states numbers
  ***************************************************************/
 void states(void) {
+  #if(MEANFIELD==1)
+    sum=0;
+    sumz=0;
+    for (int c=0; c<ncls; c++) {
+      if ((c/nlev)%2==0) sum += cnt[c];
+      if (c%nlev>=zlev) sumz += cnt[c];
+    }
+    activesum = (long)qt[0]*qt[1];
+    return;
+  #endif
   sum=N;
   sumz=0;
-  activesum=0;
+  #if(COMPLEX==0)
+    activesum=0;
+  #elif(LINKUPDATE==1)
+    for (int i=0; i<N; i++) bring(i,tnow);
+  #endif
   for (int i=0; i<N; i++) {
     if (memory[i]!=0) sum--;
     if (zealot[i]!=0) sumz++;
     #if(COMPLEX==0)
       if (spin[right[i]]!=spin[i]) activesum++;
       if (spin[down[i]]!=spin[i]) activesum++;
-    #else
-      for(int j = 0; j<kn[i]; j++){
-        if(spin[i]!=spin[j])activesum++;        
-      }
     #endif
   }
 }
- /**************************************************************
- *                       Measures Vector     // Medidas Logarítmicas
+
+#if(MEANFIELD==1)
+/**************************************************************
+ *              Cluster measures (complete graph)
+ *
+ *  All agents of an opinion are linked: one cluster each.
  *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
+void clusters(void) {
+  numc = (qt[0]>0) + (qt[1]>0);
+  mx1 = (qt[0]>qt[1]) ? qt[0] : qt[1];
+  mx2 = (numc==2) ? N-mx1 : 0;
+}
+#elif(COMPLEX==1)
+/****************************************************************
+ *               Active links of a network
+ *
+ *  activesum (discordant links, each one once) is counted here
+ *  at the start and then kept by sweep(): a flip of a node
+ *  turns its d discordant links into concordant ones and the
+ *  other k-d into discordant ones.
+ ***************************************************************/
+int discordant(int node) {
+  int d=0;
+  for(long e=net.off[node]; e<net.off[node+1]; e++){
+    if(spin[net.adj[e]]!=spin[node])d++;
+  }
+  return d;
+}
+
+void activelinks(void) {
+  activesum=0;
+  for(int i=0; i<N; i++){
+    for(long e=net.off[i]; e<net.off[i+1]; e++){
+      if(net.adj[e]>i && spin[net.adj[e]]!=spin[i])activesum++;
     }
-    if(i/(pow(10,n))==10)n++;
   }
-  return;
 }
 
- /**************************************************************
- *                       Measures Vector    // Número de medidas
+/**************************************************************
+ *                    Cluster measures
+ *
+ *  Same opinion components of the network by union-find
+ *  (label[] as parents, union by size, path halving): numc,
+ *  mx1, mx2 and the histogram of sizes his[], as
+ *  hoshen_kopelman() on the lattice.
  *************************************************************/
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
+int root(int i) {
+  while(label[i]!=i){
+    label[i] = label[label[i]];
+    i = label[i];
   }
-  return;
+  return i;
 }
 
+void clusters(void) {
+  if(label==NULL){
+    label = malloc(N*sizeof(int));
+    siz = malloc(N*sizeof(int));
+    his = realloc(his,(N+1)*sizeof(int));
+  }
+  for(int i=0; i<N; i++){
+    label[i] = i;
+    siz[i] = 1;
+    his[i] = 0;
+  }
+  his[N] = 0;
+
+  for(int i=0; i<N; i++){
+    for(long e=net.off[i]; e<net.off[i+1]; e++){
+      int w = net.adj[e];
+      if(w<i || spin[w]!=spin[i])continue;
+      int a = root(i), b = root(w);
+      if(a==b)continue;
+      if(siz[a]<siz[b]){
+        int t=a; a=b; b=t;
+      }
+      label[b] = a;
+      siz[a] += siz[b];
+    }
+  }
+
+  numc=0;
+  mx1=0;
+  mx2=0;
+  for(int i=0; i<N; i++){
+    if(label[i]!=i)continue;
+    his[siz[i]]++;
+    numc++;
+    if(siz[i]>=mx1){
+      mx2 = mx1;
+      mx1 = siz[i];
+    }
+    else if(siz[i]>mx2)mx2 = siz[i];
+  }
+}
+#endif
 /**************************************************************
  *                      Teste
  *************************************************************/
@@ -407,13 +852,15 @@ bool probcheck(double _ALPHA) {
  *************************************************************/
 void visualize(int _j,unsigned long _seed) {
   int l;
-  printf("pl '-' matrix w image t 'time = %d seed = %ld'\n",_j,_seed);
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
   for(l = N-1; l >= 0; l--) {
-    if(zealot[l]==1)printf("%d ", spin[l]+1);
-    else printf("%d ", spin[l]);
-    if( l%L == 0 ) printf("\n");
+    if(zealot[l]==1)cell[N-1-l]=spin[l]+1;
+    else cell[N-1-l]=spin[l];
   }
-  printf("e\n");
+  snprintf(title,sizeof title,"time = %d seed = %ld",_j,_seed);
+  vis_emit(title);
 }
 
 #ifdef SNAPSHOTS
@@ -424,6 +871,7 @@ void visualize(int _j,unsigned long _seed) {
     int l;
     int identifier = 0;
     char teste[100];
+    uint8_t *frame = malloc(N*sizeof(uint8_t));
 
     lat2eps_init(L,L);
     lat2eps_set_color(0,0x00000); //black
@@ -437,22 +885,33 @@ void visualize(int _j,unsigned long _seed) {
     
     for(l=0; l<N; l++) {
       if(spin[l]==1) {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,4);
-        else lat2eps_set_site(l%L,l/L,6);
+        if(certainty[l]>=1)frame[l]=4;
+        else frame[l]=6;
       }
       else {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,5);
-        else lat2eps_set_site(l%L,l/L,7);
+        if(certainty[l]>=1)frame[l]=5;
+        else frame[l]=7;
       } 
     }
 
-    snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+    #ifdef PNGSNAPS
+      const char *ext = "png";
+    #else
+      const char *ext = "eps";
+    #endif
+    snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     while(exists(teste)==true) {
       identifier++;
-      snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+      snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     }
-    lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #ifdef PNGSNAPS
+      lat2eps_gen_raster(teste,frame,L,L,3,LAT2EPS_PNG);
+    #else
+      lat2eps_set_lattice(frame);
+      lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #endif
     lat2eps_release();
+    free(frame);
   }
 #endif
 
@@ -604,7 +1063,19 @@ void openfiles(void) {
   char output_file1[300];
   char teste[250];
 
-  sprintf(root_name,"binarytrans-SIZ%d-DETA%.5f",N,DETA);
+  #if(COMPLEX==0)
+    sprintf(root_name,"binarytrans-SIZ%d-DETA%.5f",N,DETA);
+  #elif(MEANFIELD==1)
+    sprintf(root_name,"binarytrans-MF-SIZ%d-DETA%.5f",N,DETA);
+  #elif(NETWORK==2)
+    sprintf(root_name,"binarytrans-%s-SIZ%d-DETA%.5f",netname[NETWORK],N,DETA);
+  #elif(NETWORK==6)
+    const char *base = strrchr(edgefile,'/');
+    base = (base==NULL) ? edgefile : base+1;
+    sprintf(root_name,"binarytrans-%.100s-SIZ%d-DETA%.5f",base,N,DETA);
+  #else
+    sprintf(root_name,"binarytrans-%s-K%.2f-SIZ%d-DETA%.5f",netname[NETWORK],kmean,N,DETA);
+  #endif
   unsigned long identifier = seed;
   #if(DEBUG==0)
     sprintf(teste,"%s_sd%ld_1.dsf",root_name,identifier);
@@ -624,9 +1095,26 @@ void openfiles(void) {
   fprintf(fp1,"# Linear Size: %d\n",L);
   #else
   fprintf(fp1,"# Size: %d\n",N);
+  #if(MEANFIELD==1)
+  fprintf(fp1,"# Network: complete graph (mean field)\n");
+  #elif(NETWORK==2)
+  fprintf(fp1,"# Network: %s (%s)\n",netname[NETWORK],degfile);
+  #elif(NETWORK==6)
+  #ifdef GIANT
+  fprintf(fp1,"# Network: %s (%s, giant component), mean degree %.4f\n",netname[NETWORK],edgefile,kmean);
+  #else
+  fprintf(fp1,"# Network: %s (%s), mean degree %.4f\n",netname[NETWORK],edgefile,kmean);
+  #endif
+  #else
+  fprintf(fp1,"# Network: %s, mean degree %.4f\n",netname[NETWORK],kmean);
+  #endif
   #endif
   fprintf(fp1,"# Incremento: %.6f\n",DETA);
+  #if(COMPLEX==0)
   fprintf(fp1,"# Time Persistence Zealots Active Clusters Big1 Perc1 Big2 Perc2\n");
+  #else
+  fprintf(fp1,"# Time Persistence Zealots Active qt[0] Clusters Big1 Big2\n");
+  #endif
   fprintf(fp1,"\n\n");
   fflush(fp1);
 
@@ -0,0 +1,381 @@
+/********************************************************************
+***                   Incremental Cluster Tracking                ***
+***                   Last Modified: 19/10/2026                   ***
+***                                                               ***
+***  Clusters of equal neighbouring spins (spin != 0) of the L x  ***
+***  L periodic lattice, kept up to date through the moves of the ***
+***  dynamics instead of relabelled at each measurement. A move   ***
+***  is a site leaving its cluster and then joining one:          ***
+***                                                               ***
+***     flip:  cl_leave(c,site); spin[site] = -spin[site];        ***
+***            cl_join(c,spin,site);                              ***
+***     hop:   cl_leave(c,site); swap spin[site], spin[target];   ***
+***            cl_join(c,spin,target);                            ***
+***                                                               ***
+***  A join merges the clusters around the site into the largest  ***
+***  of them, relabelling the smaller ones (union by size, with   ***
+***  the labels kept flat). A leave checks for a split by         ***
+***  breadth-first searches from the neighbours of the site in    ***
+***  the cluster, run side by side: searches that meet are joined ***
+***  and one that runs out of sites has found a piece on its own, ***
+***  which gets a new label, so the cost goes with the smaller    ***
+***  pieces. Clusters are kept in lists by size, giving the       ***
+***  number of clusters and the two largest in O(1) (plus a scan  ***
+***  of a bitmap of sizes); the percolation of a cluster is       ***
+***  checked on its own sites only.                               ***
+***                                                               ***
+***  cl_init(c,spin,l)      label the lattice                     ***
+***  cl_leave(c,site)       site leaves its cluster               ***
+***  cl_join(c,spin,site)   site (spin set) joins its neighbours  ***
+***  cl_stats(c,&numc,&mx1,&mx2,&perc1,&perc2)                    ***
+********************************************************************/
+
+#ifndef CLUSTERS_H
+#define CLUSTERS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  int l, n;                     /* linear size and sites                  */
+  int *lab;                     /* cluster of each site, -1 for none      */
+  int *next, *prev;             /* sites of each cluster, linked          */
+  int *first, *size;            /* first site and size of each cluster    */
+  int *unused, nunused;         /* labels free for new clusters           */
+  int *head, *bnext, *bprev;    /* clusters of each size, linked          */
+  int *his;                     /* number of clusters of each size        */
+  unsigned long long *bits;     /* sizes with his > 0                     */
+  int numc;                     /* number of clusters                     */
+  int *queue[4], *mark, *owner; /* split searches                         */
+  int stamp;
+  int *rows, *cols;             /* percolation check                      */
+} clusters;
+
+/********************************************************************
+*                        Lattice neighbours                         *
+********************************************************************/
+void cl_neigh(const clusters *c, int s, int *nb)
+{
+  int l = c->l;
+  nb[0] = (s+1)%l + (s/l)*l;
+  nb[1] = (s-1+l)%l + (s/l)*l;
+  nb[2] = (s-l+c->n)%c->n;
+  nb[3] = (s+l)%c->n;
+}
+
+/********************************************************************
+*                     Lists of clusters by size                     *
+********************************************************************/
+void cl_bucket_out(clusters *c, int id)
+{
+  int s = c->size[id];
+  if (c->bprev[id] != -1) c->bnext[c->bprev[id]] = c->bnext[id];
+  else c->head[s] = c->bnext[id];
+  if (c->bnext[id] != -1) c->bprev[c->bnext[id]] = c->bprev[id];
+  if (--c->his[s] == 0) c->bits[s>>6] &= ~(1ULL<<(s&63));
+}
+
+void cl_bucket_in(clusters *c, int id)
+{
+  int s = c->size[id];
+  c->bprev[id] = -1;
+  c->bnext[id] = c->head[s];
+  if (c->head[s] != -1) c->bprev[c->head[s]] = id;
+  c->head[s] = id;
+  if (c->his[s]++ == 0) c->bits[s>>6] |= 1ULL<<(s&63);
+}
+
+void cl_resize(clusters *c, int id, int size)
+{
+  cl_bucket_out(c,id);
+  c->size[id] = size;
+  cl_bucket_in(c,id);
+}
+
+/* largest size <= s with a cluster, 0 if none */
+int cl_below(const clusters *c, int s)
+{
+  if (s <= 0) return 0;
+  int w = s>>6;
+  unsigned long long b = c->bits[w] & (~0ULL >> (63-(s&63)));
+  while (b == 0) {
+    if (w == 0) return 0;
+    b = c->bits[--w];
+  }
+  return (w<<6) + 63 - __builtin_clzll(b);
+}
+
+/********************************************************************
+*                        Sites of a cluster                         *
+********************************************************************/
+void cl_link(clusters *c, int id, int s)
+{
+  c->lab[s] = id;
+  c->prev[s] = -1;
+  c->next[s] = c->first[id];
+  if (c->first[id] != -1) c->prev[c->first[id]] = s;
+  c->first[id] = s;
+}
+
+void cl_unlink(clusters *c, int s)
+{
+  int id = c->lab[s];
+  if (c->prev[s] != -1) c->next[c->prev[s]] = c->next[s];
+  else c->first[id] = c->next[s];
+  if (c->next[s] != -1) c->prev[c->next[s]] = c->prev[s];
+  c->lab[s] = -1;
+}
+
+/* new mark for the searches, clearing the old ones on overflow */
+int cl_stamp(clusters *c)
+{
+  if (++c->stamp == 0x7fffffff) {
+    for (int i = 0; i < c->n; i++) c->mark[i] = 0;
+    for (int i = 0; i < c->l; i++) c->rows[i] = c->cols[i] = 0;
+    c->stamp = 1;
+  }
+  return c->stamp;
+}
+
+int cl_new(clusters *c)
+{
+  int id = c->unused[--c->nunused];
+  c->first[id] = -1;
+  c->size[id] = 0;
+  c->numc++;
+  return id;
+}
+
+void cl_delete(clusters *c, int id)
+{
+  c->unused[c->nunused++] = id;
+  c->numc--;
+}
+
+/********************************************************************
+*                          Initialization                           *
+********************************************************************/
+void cl_init(clusters *c, const int *spin, int l)
+{
+  int n = l*l;
+  int nb[4];
+
+  c->l = l;
+  c->n = n;
+  c->lab = malloc(n*sizeof(int));
+  c->next = malloc(n*sizeof(int));
+  c->prev = malloc(n*sizeof(int));
+  c->first = malloc(n*sizeof(int));
+  c->size = malloc(n*sizeof(int));
+  c->unused = malloc(n*sizeof(int));
+  c->head = malloc((n+1)*sizeof(int));
+  c->bnext = malloc(n*sizeof(int));
+  c->bprev = malloc(n*sizeof(int));
+  c->his = calloc(n+1,sizeof(int));
+  c->bits = calloc(n/64+1,sizeof(unsigned long long));
+  c->mark = calloc(n,sizeof(int));
+  c->owner = malloc(n*sizeof(int));
+  c->rows = calloc(l,sizeof(int));
+  c->cols = calloc(l,sizeof(int));
+  for (int q = 0; q < 4; q++) c->queue[q] = malloc(n*sizeof(int));
+  if (c->queue[3]==NULL || c->cols==NULL || c->bits==NULL || c->his==NULL) {
+    fprintf(stderr,"cl_init: out of memory (L = %d)\n",l);
+    exit(1);
+  }
+
+  c->nunused = n;
+  for (int i = 0; i < n; i++) {
+    c->unused[i] = n-1-i;
+    c->lab[i] = -1;
+  }
+  for (int s = 0; s <= n; s++) c->head[s] = -1;
+  c->numc = 0;
+  c->stamp = 0;
+
+  int *queue = c->queue[0];
+  for (int i = 0; i < n; i++) {
+    if (spin[i]==0 || c->lab[i]!=-1) continue;
+    int id = cl_new(c);
+    int h = 0, t = 0;
+    cl_link(c,id,i);
+    queue[t++] = i;
+    while (h < t) {
+      cl_neigh(c,queue[h++],nb);
+      for (int j = 0; j < 4; j++) {
+        if (spin[nb[j]]==spin[i] && c->lab[nb[j]]==-1) {
+          cl_link(c,id,nb[j]);
+          queue[t++] = nb[j];
+        }
+      }
+    }
+    c->size[id] = t;
+    cl_bucket_in(c,id);
+  }
+}
+
+/********************************************************************
+*                      A site joins a cluster                       *
+********************************************************************/
+void cl_join(clusters *c, const int *spin, int site)
+{
+  int nb[4], ids[4], k = 0;
+  int big = -1;
+
+  cl_neigh(c,site,nb);
+  for (int j = 0; j < 4; j++) {
+    int id = c->lab[nb[j]];
+    if (id == -1 || spin[nb[j]] != spin[site]) continue;
+    int known = 0;
+    for (int m = 0; m < k; m++) if (ids[m] == id) known = 1;
+    if (known) continue;
+    ids[k++] = id;
+    if (big == -1 || c->size[id] > c->size[big]) big = id;
+  }
+
+  if (big == -1) {
+    big = cl_new(c);
+    cl_link(c,big,site);
+    c->size[big] = 1;
+    cl_bucket_in(c,big);
+    return;
+  }
+
+  int size = c->size[big] + 1;
+  for (int m = 0; m < k; m++) {
+    int id = ids[m];
+    if (id == big) continue;
+    int s = c->first[id], last = s;
+    for (; s != -1; s = c->next[s]) {
+      c->lab[s] = big;
+      last = s;
+    }
+    c->next[last] = c->first[big];
+    c->prev[c->first[big]] = last;
+    c->first[big] = c->first[id];
+    size += c->size[id];
+    cl_bucket_out(c,id);
+    cl_delete(c,id);
+  }
+  cl_link(c,big,site);
+  cl_resize(c,big,size);
+}
+
+/********************************************************************
+*                     A site leaves its cluster                     *
+********************************************************************/
+void cl_leave(clusters *c, int site)
+{
+  int id = c->lab[site];
+  int nb[4], start[4], k = 0;
+
+  cl_unlink(c,site);
+  if (c->size[id] == 1) {
+    cl_bucket_out(c,id);
+    cl_delete(c,id);
+    return;
+  }
+  cl_resize(c,id,c->size[id]-1);
+
+  cl_neigh(c,site,nb);
+  for (int j = 0; j < 4; j++) if (c->lab[nb[j]] == id) start[k++] = nb[j];
+  if (k < 2) return;
+
+  /* searches side by side, group[] joins the ones that met */
+  int h[4], t[4], group[4], done[4], live = k;
+  cl_stamp(c);
+  for (int q = 0; q < k; q++) {
+    c->queue[q][0] = start[q];
+    c->mark[start[q]] = c->stamp;
+    c->owner[start[q]] = q;
+    h[q] = 0;
+    t[q] = 1;
+    group[q] = q;
+    done[q] = 0;
+  }
+
+  while (live > 1) {
+    for (int q = 0; q < k && live > 1; q++) {
+      if (h[q] == t[q]) continue;
+      cl_neigh(c,c->queue[q][h[q]++],nb);
+      for (int j = 0; j < 4 && live > 1; j++) {
+        int s = nb[j];
+        if (c->lab[s] != id) continue;
+        if (c->mark[s] != c->stamp) {
+          c->mark[s] = c->stamp;
+          c->owner[s] = q;
+          c->queue[q][t[q]++] = s;
+        }
+        else if (group[c->owner[s]] != group[q]) {
+          int from = group[c->owner[s]], to = group[q];
+          for (int p = 0; p < k; p++) if (group[p] == from) group[p] = to;
+          live--;
+        }
+      }
+    }
+    /* a group with no sites left to visit is a piece on its own */
+    for (int g = 0; g < k && live > 1; g++) {
+      if (done[g] || group[g] != g) continue;
+      int open = 0;
+      for (int q = 0; q < k; q++) if (group[q] == g && h[q] < t[q]) open = 1;
+      if (open) continue;
+      int piece = cl_new(c), size = 0;
+      for (int q = 0; q < k; q++) {
+        if (group[q] != g) continue;
+        for (int m = 0; m < t[q]; m++) {
+          cl_unlink(c,c->queue[q][m]);
+          cl_link(c,piece,c->queue[q][m]);
+        }
+        size += t[q];
+      }
+      c->size[piece] = size;
+      cl_bucket_in(c,piece);
+      cl_resize(c,id,c->size[id]-size);
+      done[g] = 1;
+      live--;
+    }
+  }
+}
+
+/********************************************************************
+*                            Percolation                            *
+*                                                                   *
+*  As percolates2d(): 1 if the cluster has a site in every column   *
+*  plus 1 if it has one in every row.                               *
+********************************************************************/
+int cl_percolates(clusters *c, int id)
+{
+  int nrows = 0, ncols = 0;
+
+  if (id == -1 || c->size[id] < c->l) return 0;
+  cl_stamp(c);
+  for (int s = c->first[id]; s != -1; s = c->next[s]) {
+    if (c->rows[s/c->l] != c->stamp) {
+      c->rows[s/c->l] = c->stamp;
+      nrows++;
+    }
+    if (c->cols[s%c->l] != c->stamp) {
+      c->cols[s%c->l] = c->stamp;
+      ncols++;
+    }
+  }
+  return (ncols==c->l) + (nrows==c->l);
+}
+
+/********************************************************************
+*                    Number and largest clusters                    *
+********************************************************************/
+void cl_stats(clusters *c, int *numc, int *mx1, int *mx2, int *perc1, int *perc2)
+{
+  int s1 = cl_below(c,c->n);
+  int s2 = (s1 > 0 && c->his[s1] > 1) ? s1 : cl_below(c,s1-1);
+  int big1 = (s1 > 0) ? c->head[s1] : -1;
+  int big2 = (s2 == s1) ? ((big1 != -1) ? c->bnext[big1] : -1) : ((s2 > 0) ? c->head[s2] : -1);
+
+  *numc = c->numc;
+  *mx1 = s1;
+  *mx2 = s2;
+  *perc1 = cl_percolates(c,big1);
+  *perc2 = cl_percolates(c,big2);
+}
+
+#endif
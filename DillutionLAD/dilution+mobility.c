@@ -19,7 +19,10 @@
 
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DPNGSNAPS [with SNAPSHOTS, PNG snapshots instead of EPS]
+// -DCLUSTERS=10 [clusters tracked through flips and hops instead of relabelled at each measurement, with 10 cluster measures per MCS in _2.dsf (see clusters.h)]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -36,6 +39,13 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
+#include "occupied.h"
+#if(CLUSTERS>0)
+  #include "clusters.h"
+  #define CSTEP (N/CLUSTERS>0 ? N/CLUSTERS : 1) //Updates between cluster measures
+#endif
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -53,7 +63,7 @@
  *                            SETTINGS 
  ***************************************************************/
 
-#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 
 /***************************************************************
  *                            FUNCTIONS                       
@@ -64,12 +74,11 @@ void openfiles(void);
 void sweep(void); 
 void visualize(int,unsigned long); 
 void states(void); 
-void measures1(void); 
-void measures2(void);
 #ifdef SNAPSHOTS
   void snap(void);  
 #endif
 void hoshen_kopelman(void);
+void cluster_measures(void);
 int biasedwalk(int qual, int *lab);
 int delta(int i, int j, int hh);
 void connections(int,int);
@@ -82,7 +91,13 @@ bool probcheck(double);
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,**neigh,*memory,*measures,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+int *spin,**neigh,*memory,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+schedule measures;
+occupied agents;
+#if(CLUSTERS>0)
+  clusters domains;
+#endif
+int sweeps;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2,CONT,LINKS;
 int probperc0,probperc1;
 int hull_perimeter;
@@ -116,7 +131,12 @@ int main(void){
   initialize();
 
   #if(VISUAL==1)
-    printf("set palette defined (-2 'black',-1 '0xff4545', 0 '0xFF0000', 1 '0x81C2EF', 2 '0x0000FF')\n");
+    vis_set_color(-2,0x000000); //black
+    vis_set_color(-1,0xFF4545); //light red
+    vis_set_color(0,0xFF0000); //red
+    vis_set_color(1,0x81C2EF); //light blue
+    vis_set_color(2,0x0000FF); //blue
+    vis_palette_out();
   #endif
   for (int j=0;j<=MCS+1;j++)  {
     #if(VISUAL==1)
@@ -125,24 +145,24 @@ int main(void){
     #else
       if( ((MOB==0 && activesum==0)) | ((MOB!=0 && (qt[0]==CONT | qt[0]==0))) ){
         states();
-        hoshen_kopelman();
+        cluster_measures();
         fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f\n",j,(double)sum/CONT,(double)sumz/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT);
         sweep();
         states();
-        hoshen_kopelman();
-        while(measures[k]!=0){
-          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f\n",measures[k],(double)sum/CONT,(double)sumz/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT);
+        cluster_measures();
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f\n",sched_time(&measures,k),(double)sum/CONT,(double)sumz/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT);
           k++;
         }           
         break;
       }
-      if (measures[k]==j) {  
+      if (sched_time(&measures,k)==j) {  
         #if(SNAPSHOTS==1)
           snap();   
           k++;        
         #else  
           states();
-          hoshen_kopelman();
+          cluster_measures();
           fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f\n",j,(double)sum/CONT,(double)sumz/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT);
           k++;
         #endif
@@ -154,6 +174,9 @@ int main(void){
   #if(SNAPSHOTS==0)
   fclose(fp1);
   #endif
+  #if(CLUSTERS>0)
+    if(fp2!=NULL)fclose(fp2);
+  #endif
 
 }
 /***************************************************************
@@ -167,7 +190,6 @@ void initialize(void) {
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
   memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   zealot = malloc(N*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
@@ -203,6 +225,10 @@ void initialize(void) {
       spin[n] = 0;
     }
   }
+  occ_init(&agents,spin,N);
+  #if(CLUSTERS>0)
+    cl_init(&domains,spin,L);
+  #endif
   #if(VISUAL==0)
     fprintf(fp1,"# Agents: %d\n",CONT);
     fprintf(fp1,"# Time Persistence Zealots Active Clusters Big1 Perc1 Big2 Perc2 qt[0]\n");
@@ -235,9 +261,11 @@ void initialize(void) {
     }
   }
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 
 }
@@ -247,8 +275,13 @@ void initialize(void) {
  ***************************************************************/
 void sweep(void) {
   for (int n=0; n<N; n++) {
-    int site = FRANDOM*N;
-    while (spin[site]==0)site = FRANDOM*N;
+    #if(CLUSTERS>0)
+      if(n%CSTEP==0 && fp2!=NULL){
+        cluster_measures();
+        fprintf(fp2,"%.8f %.8f %.8f %d %.8f %d\n",sweeps+(double)n/N,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1);
+      }
+    #endif
+    int site = occ_pick(&agents);
     //Opinion dynamics    
     int dir = FRANDOM*4;
     int neighbour = neigh[site][dir];
@@ -261,9 +294,15 @@ void sweep(void) {
           if(spin[down[site]]==-spin[site])INTERFANTES++;
           if(spin[left[site]]==-spin[site])INTERFANTES++;
           memory[site]=1;
+          #if(CLUSTERS>0)
+            cl_leave(&domains,site);
+          #endif
           qt[(spin[site] + 1 )/2]--;
           spin[site] = spin[neighbour];
           qt[(spin[neighbour] + 1 )/2]++;
+          #if(CLUSTERS>0)
+            cl_join(&domains,spin,site);
+          #endif
           int INTERFDEPOIS=0;
           if(spin[up[site]]==-spin[site])INTERFDEPOIS++;
           if(spin[right[site]]==-spin[site])INTERFDEPOIS++;
@@ -295,10 +334,16 @@ void sweep(void) {
         if(spin[right[site]]==-spin[site])INTERFANTES++;
         if(spin[down[site]]==-spin[site])INTERFANTES++;
         if(spin[left[site]]==-spin[site])INTERFANTES++;
+        #if(CLUSTERS>0)
+          cl_leave(&domains,site);
+        #endif
         int focalspin = spin[site];
         spin[site]=spin[neighbour];
         spin[neighbour]=focalspin;
-        int focalconf = certainty[site];
+        #if(CLUSTERS>0)
+          cl_join(&domains,spin,neighbour);
+        #endif
+        double focalconf = certainty[site];
         certainty[site]=certainty[neighbour];
         certainty[neighbour]=focalconf;
         int focalz = zealot[site];
@@ -307,6 +352,7 @@ void sweep(void) {
         int focalmemory = memory[site];
         memory[site]=memory[neighbour];
         memory[neighbour]=focalmemory;
+        occ_move(&agents,site,neighbour);
         int INTERFDEPOIS=0;
         if(spin[up[neighbour]]==-spin[neighbour])INTERFDEPOIS++;
         if(spin[right[neighbour]]==-spin[neighbour])INTERFDEPOIS++;
@@ -316,6 +362,7 @@ void sweep(void) {
       }
     }
   }
+  sweeps++;
 }
 
 /****************************************************************
@@ -335,37 +382,6 @@ void states(void) {
     }
   }
 }
- /**************************************************************
- *                       Measures Vector     // Medidas Logarítmicas
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
-    }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
- /**************************************************************
- *                       Measures Vector    // Número de medidas
- *************************************************************/
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
-  }
-  return;
-}
-
 /**************************************************************
  *                      Teste
  *************************************************************/
@@ -381,18 +397,20 @@ bool probcheck(double _ALPHA) {
  *************************************************************/
 void visualize(int _j,unsigned long _seed) {
   int l;
-  printf("pl '-' matrix w image t 'time = %d seed = %ld'\n",_j,_seed);
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
   for(l = N-1; l >= 0; l--) {
     if(spin[l]!=0){  
-      if(zealot[l]==1)printf("%d ", spin[l]+1);
-      else printf("%d ", spin[l]);
+      if(zealot[l]==1)cell[N-1-l]=spin[l]+1;
+      else cell[N-1-l]=spin[l];
     }
     else{
-      printf("%d ", -2);
+      cell[N-1-l]=-2;
     }
-    if( l%L == 0 ) printf("\n");
   }
-  printf("e\n");
+  snprintf(title,sizeof title,"time = %d seed = %ld",_j,_seed);
+  vis_emit(title);
 }
 
 #ifdef SNAPSHOTS
@@ -403,6 +421,7 @@ void visualize(int _j,unsigned long _seed) {
     int l;
     int identifier = 0;
     char teste[100];
+    uint8_t *frame = malloc(N*sizeof(uint8_t));
 
     lat2eps_init(L,L);
     lat2eps_set_color(0,0x00000); //black
@@ -416,22 +435,33 @@ void visualize(int _j,unsigned long _seed) {
 
     for(l=0; l<N; l++) {
       if(spin[l]==1) {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,4);
-        else lat2eps_set_site(l%L,l/L,6);
+        if(certainty[l]>=1)frame[l]=4;
+        else frame[l]=6;
       }
       else {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,5);
-        else lat2eps_set_site(l%L,l/L,7);
+        if(certainty[l]>=1)frame[l]=5;
+        else frame[l]=7;
       } 
     }
 
-    snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+    #ifdef PNGSNAPS
+      const char *ext = "png";
+    #else
+      const char *ext = "eps";
+    #endif
+    snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     while(exists(teste)==true) {
       identifier++;
-      snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+      snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     }
-    lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #ifdef PNGSNAPS
+      lat2eps_gen_raster(teste,frame,L,L,3,LAT2EPS_PNG);
+    #else
+      lat2eps_set_lattice(frame);
+      lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #endif
     lat2eps_release();
+    free(frame);
   }
 #endif
 
@@ -439,6 +469,14 @@ void visualize(int _j,unsigned long _seed) {
 /**************************************************************
  *                    Cluster measures                   
  *************************************************************/
+void cluster_measures(void) {
+  #if(CLUSTERS>0)
+    cl_stats(&domains,&numc,&mx1,&mx2,&probperc0,&probperc1);
+  #else
+    hoshen_kopelman();
+  #endif
+}
+
 void hoshen_kopelman(void) {
   
   int i,j,temp1,temp2;
@@ -615,6 +653,16 @@ void openfiles(void) {
   fprintf(fp1,"# Incremento: %.6f\n",DETA);
   fflush(fp1);
 
+  #if(CLUSTERS>0)
+    sprintf(output_file1,"%s_2.dsf",teste);
+    fp2 = fopen(output_file1,"w");
+    fprintf(fp2,"# LAD Voter Model 2D Cluster Measures (%d per MCS)\n",CLUSTERS);
+    fprintf(fp2,"# Seed: %ld\n",seed);
+    fprintf(fp2,"# Linear size: %d\n",L);
+    fprintf(fp2,"# Time Clusters Big1 Perc1 Big2 Perc2\n");
+    fflush(fp2);
+  #endif
+
   return;
   
 }
@@ -0,0 +1,412 @@
+/*************************************************************************
+*                   Ensemble average of main outputs                     *
+*                             V1.0 19/10/2026                            *
+*************************************************************************/
+
+/***************************************************************
+ *                            USAGE
+ **************************************************************/
+// gcc -O3 -pthread dsfaverage.c -o dsfaverage -lm
+// ./dsfaverage [-j THREADS] [-o medias.dsf] files_1.dsf ...
+// ls | grep _1.dsf | ./dsfaverage -o medias.dsf    [names from stdin]
+//
+// medias.dsf: header of the first file, then one line per
+// measurement with the mean of every column and the number of
+// samples, as the medias*.dsf files of this directory.
+// medias.dsf.var: same lines with the variance of every column,
+// the number of samples and of surviving samples (runs that had
+// not reached consensus yet at that measurement).
+//
+// Runs are aligned by measurement (the k-th line of data of each
+// run), not by the value of the time column, which is the time
+// of the update that crossed measures[k] and differs from run to
+// run. A run that stops at consensus writes one extra line (the
+// consensus time) and then repeats the absorbing state for every
+// remaining measurement: that line is taken out (its time goes to
+// the consensus statistics of the .var header) and the repeated
+// ones count as samples but not as surviving ones. The consensus
+// line is the first of the lines at the end of the run whose
+// columns, the time aside, are all the same, when there are at
+// least two of them and the ones after it are at whole times (the
+// times of the measurements; a run frozen in a state that is not
+// the consensus one goes on with the times of its updates).
+// A file with several runs one after the other (cat of outputs,
+// dsfarchive get) is read as several samples.
+
+/***************************************************************
+ *                            INCLUDES
+ **************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/****************************************************************
+ *                       PARAMETERS DEFINITIONS
+ ***************************************************************/
+
+#define MAXCOL      32    //Max columns of a line
+#define MAXLINE     1024  //Max length of a line
+#define MAXHEAD     8192  //Max length of the header
+
+/***************************************************************
+ *                            FUNCTIONS
+ **************************************************************/
+
+typedef struct {
+  int rows;             /* measurements with room               */
+  long *n;              /* samples per measurement              */
+  long *surv;           /* surviving samples per measurement    */
+  double *mean, *m2;    /* running mean and M2 per column       */
+  long samples, consensus, skipped;
+  double tmean, tm2;    /* consensus times                      */
+} accum;
+
+void *worker(void *);
+void average(accum *, const char *, const char *, size_t);
+void sample(accum *, const double *, int);
+void grow(accum *, int);
+void merge(accum *, const accum *);
+int parseline(const char *, const char *, double *);
+int header(const char *, char *, size_t);
+bool same(const double *, const double *);
+void output(const char *, const char *);
+
+/***************************************************************
+ *                         GLOBAL VARIABLES
+ **************************************************************/
+
+char **files;
+int nfiles, next=0, ncol=0;
+pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+accum total;
+
+/***************************************************************
+ *                          MAIN PROGRAM
+ **************************************************************/
+int main(int argc, char *argv[]){
+  const char *out = "medias.dsf";
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int i=1;
+
+  for(; i<argc && argv[i][0]=='-' && argv[i][1]!='\0'; i++){
+    if(strcmp(argv[i],"-j")==0 && i+1<argc)threads = atoi(argv[++i]);
+    else if(strcmp(argv[i],"-o")==0 && i+1<argc)out = argv[++i];
+    else {
+      fprintf(stderr,"Usage: %s [-j THREADS] [-o medias.dsf] files_1.dsf ...\n",argv[0]);
+      return 1;
+    }
+  }
+  if(threads<1)threads=1;
+
+  if(i<argc){
+    files = argv+i;
+    nfiles = argc-i;
+  }
+  else {
+    char line[MAXLINE];
+    int size=1024;
+    files = malloc(size*sizeof(char*));
+    nfiles = 0;
+    while(fgets(line,sizeof line,stdin)!=NULL){
+      line[strcspn(line,"\n")] = '\0';
+      if(line[0]=='\0')continue;
+      if(nfiles==size){
+        size *= 2;
+        files = realloc(files,size*sizeof(char*));
+      }
+      files[nfiles++] = strdup(line);
+    }
+  }
+  if(nfiles==0){
+    fprintf(stderr,"no files\n");
+    return 1;
+  }
+  if(threads>nfiles)threads = nfiles;
+
+  char head[MAXHEAD];
+  ncol = header(files[0],head,sizeof head);
+  if(ncol<2){
+    fprintf(stderr,"%s: no data lines\n",files[0]);
+    return 1;
+  }
+
+  accum *acc = calloc(threads,sizeof(accum));
+  pthread_t *tid = malloc(threads*sizeof(pthread_t));
+  for(int t=0; t<threads; t++)pthread_create(&tid[t],NULL,worker,&acc[t]);
+  for(int t=0; t<threads; t++)pthread_join(tid[t],NULL);
+  for(int t=0; t<threads; t++)merge(&total,&acc[t]);
+
+  output(out,head);
+  fprintf(stderr,"%ld samples (%ld reached consensus), %ld skipped\n",total.samples,total.consensus,total.skipped);
+
+  return 0;
+}
+
+/**************************************************************
+ *       Header lines and number of columns of a file
+ *************************************************************/
+int header(const char *fname, char *head, size_t size){
+  char line[MAXLINE];
+  double v[MAXCOL];
+  size_t used=0;
+  int n=0;
+  FILE *fp;
+
+  head[0] = '\0';
+  fp = fopen(fname,"r");
+  if(fp==NULL)return 0;
+  while(fgets(line,sizeof line,fp)!=NULL){
+    if(line[0]=='#'){
+      size_t len = strlen(line);
+      if(used+len<size){
+        memcpy(head+used,line,len+1);
+        used += len;
+      }
+      continue;
+    }
+    n = parseline(line,line+strlen(line),v);
+    if(n>0)break;
+  }
+  fclose(fp);
+  return n;
+}
+
+/**************************************************************
+ *       Numbers of a line (0 for comments and blank lines)
+ *
+ *  The line is copied before strtod, a mapped file has no
+ *  '\0' at its end.
+ *************************************************************/
+int parseline(const char *p, const char *end, double *v){
+  char buf[MAXLINE];
+  size_t len = end-p;
+  int n=0;
+
+  if(len==0 || p[0]=='#')return 0;
+  if(len>=sizeof buf)len = sizeof buf-1;
+  memcpy(buf,p,len);
+  buf[len] = '\0';
+
+  char *s = buf, *e;
+  while(n<MAXCOL){
+    double x = strtod(s,&e);
+    if(e==s)break;
+    v[n++] = x;
+    s = e;
+  }
+  return n;
+}
+
+/**************************************************************
+ *       Threads: one file at a time from the list
+ *************************************************************/
+void *worker(void *arg){
+  accum *a = arg;
+
+  for(;;){
+    pthread_mutex_lock(&lock);
+    int f = next++;
+    pthread_mutex_unlock(&lock);
+    if(f>=nfiles)break;
+
+    struct stat st;
+    int fd = open(files[f],O_RDONLY);
+    if(fd<0 || fstat(fd,&st)!=0){
+      fprintf(stderr,"%s: can not be read\n",files[f]);
+      if(fd>=0)close(fd);
+      a->skipped++;
+      continue;
+    }
+    if(st.st_size==0){
+      close(fd);
+      continue;
+    }
+    char *map = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(map==MAP_FAILED){
+      fprintf(stderr,"%s: can not be mapped\n",files[f]);
+      a->skipped++;
+      continue;
+    }
+    madvise(map,st.st_size,MADV_SEQUENTIAL);
+    average(a,files[f],map,st.st_size);
+    munmap(map,st.st_size);
+  }
+  return NULL;
+}
+
+/**************************************************************
+ *       Runs of a mapped file
+ *
+ *  The data lines of a run are kept until its end (a comment
+ *  line after data lines or the end of the file), the consensus
+ *  line is only known then.
+ *************************************************************/
+void average(accum *a, const char *fname, const char *map, size_t size){
+  const char *p = map, *end = map+size;
+  double *rows = NULL, v[MAXCOL];
+  int nrows=0, room=0;
+  bool bad=false;
+
+  while(p<end){
+    const char *eol = memchr(p,'\n',end-p);
+    if(eol==NULL)eol = end;
+    int n = parseline(p,eol,v);
+
+    if(n==0 && p<eol && p[0]=='#' && (nrows>0 || bad)){
+      if(bad)a->skipped++;
+      else sample(a,rows,nrows);
+      nrows = 0;
+      bad = false;
+    }
+    if(n>0 && n!=ncol){
+      if(!bad)fprintf(stderr,"%s: %d columns instead of %d, run skipped\n",fname,n,ncol);
+      bad = true;
+    }
+    else if(n>0){
+      if(nrows==room){
+        room = (room==0) ? 256 : 2*room;
+        rows = realloc(rows,(size_t)room*ncol*sizeof(double));
+      }
+      memcpy(rows+(size_t)nrows*ncol,v,ncol*sizeof(double));
+      nrows++;
+    }
+    p = eol+1;
+  }
+  if(bad)a->skipped++;
+  else if(nrows>0)sample(a,rows,nrows);
+  free(rows);
+}
+
+/**************************************************************
+ *       Columns other than the time equal
+ *************************************************************/
+bool same(const double *x, const double *y){
+  for(int c=1; c<ncol; c++)if(x[c]!=y[c])return false;
+  return true;
+}
+
+/**************************************************************
+ *       One run into the accumulators
+ *************************************************************/
+void sample(accum *a, const double *rows, int nrows){
+  int first = nrows-1, cons = -1;
+
+  while(first>0 && same(rows+(size_t)(first-1)*ncol,rows+(size_t)(nrows-1)*ncol))first--;
+  if(nrows-first>=2)cons = first;
+  for(int r=first+1; r<nrows && cons>=0; r++)if(rows[(size_t)r*ncol]!=floor(rows[(size_t)r*ncol]))cons = -1;
+
+  a->samples++;
+  if(cons>=0){
+    double t = rows[(size_t)cons*ncol], d = t-a->tmean;
+    a->consensus++;
+    a->tmean += d/a->consensus;
+    a->tm2 += d*(t-a->tmean);
+  }
+
+  grow(a,nrows);
+  for(int r=0, k=0; r<nrows; r++){
+    if(r==cons)continue;
+    const double *x = rows+(size_t)r*ncol;
+    double *mean = a->mean+(size_t)k*ncol, *m2 = a->m2+(size_t)k*ncol;
+    long n = ++a->n[k];
+    for(int c=0; c<ncol; c++){
+      double d = x[c]-mean[c];
+      mean[c] += d/n;
+      m2[c] += d*(x[c]-mean[c]);
+    }
+    if(cons<0 || r<cons)a->surv[k]++;
+    k++;
+  }
+}
+
+/**************************************************************
+ *       Room for "rows" measurements
+ *************************************************************/
+void grow(accum *a, int rows){
+  if(rows<=a->rows)return;
+  int room = (a->rows==0) ? rows : a->rows;
+  while(room<rows)room *= 2;
+
+  a->n = realloc(a->n,room*sizeof(long));
+  a->surv = realloc(a->surv,room*sizeof(long));
+  a->mean = realloc(a->mean,(size_t)room*ncol*sizeof(double));
+  a->m2 = realloc(a->m2,(size_t)room*ncol*sizeof(double));
+  memset(a->n+a->rows,0,(room-a->rows)*sizeof(long));
+  memset(a->surv+a->rows,0,(room-a->rows)*sizeof(long));
+  memset(a->mean+(size_t)a->rows*ncol,0,(size_t)(room-a->rows)*ncol*sizeof(double));
+  memset(a->m2+(size_t)a->rows*ncol,0,(size_t)(room-a->rows)*ncol*sizeof(double));
+  a->rows = room;
+}
+
+/**************************************************************
+ *       Accumulators of a thread into the total
+ *
+ *  Means and M2 of two sets joined as in Chan et al.
+ *************************************************************/
+void merge(accum *a, const accum *b){
+  grow(a,b->rows);
+  for(int k=0; k<b->rows; k++){
+    long na = a->n[k], nb = b->n[k], n = na+nb;
+    if(nb==0)continue;
+    for(int c=0; c<ncol; c++){
+      size_t i = (size_t)k*ncol+c;
+      double d = b->mean[i]-a->mean[i];
+      a->mean[i] += d*nb/n;
+      a->m2[i] += b->m2[i]+d*d*na*nb/n;
+    }
+    a->n[k] = n;
+    a->surv[k] += b->surv[k];
+  }
+
+  long ca = a->consensus, cb = b->consensus, c = ca+cb;
+  if(cb>0){
+    double d = b->tmean-a->tmean;
+    a->tmean += d*cb/c;
+    a->tm2 += b->tm2+d*d*ca*cb/c;
+  }
+  a->consensus = c;
+  a->samples += b->samples;
+  a->skipped += b->skipped;
+}
+
+/**************************************************************
+ *       Averages (medias.dsf) and variances (medias.dsf.var)
+ *************************************************************/
+void output(const char *out, const char *head){
+  char name[1024];
+  FILE *fp1,*fp2;
+
+  snprintf(name,sizeof name,"%s.var",out);
+  fp1 = fopen(out,"w");
+  fp2 = fopen(name,"w");
+  if(fp1==NULL || fp2==NULL){
+    fprintf(stderr,"%s: can not be written\n",(fp1==NULL)?out:name);
+    exit(1);
+  }
+
+  fprintf(fp1,"%s",head);
+  fprintf(fp2,"%s",head);
+  fprintf(fp2,"# Samples: %ld\n",total.samples);
+  fprintf(fp2,"# Consensus: %ld\n",total.consensus);
+  fprintf(fp2,"# Consensus time: %.8f %.8f\n",total.tmean,(total.consensus>1)?total.tm2/(total.consensus-1):0.);
+  fprintf(fp2,"# Variances ... Samples Surviving\n");
+
+  for(int k=0; k<total.rows && total.n[k]>0; k++){
+    long n = total.n[k];
+    for(int c=0; c<ncol; c++)fprintf(fp1,"%s%.8f",(c>0)?" ":"",total.mean[(size_t)k*ncol+c]);
+    fprintf(fp1," %ld\n",n);
+    for(int c=0; c<ncol; c++)fprintf(fp2,"%s%.8f",(c>0)?" ":"",(n>1)?total.m2[(size_t)k*ncol+c]/(n-1):0.);
+    fprintf(fp2," %ld %ld\n",n,total.surv[k]);
+  }
+  fclose(fp1);
+  fclose(fp2);
+}
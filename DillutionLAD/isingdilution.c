@@ -19,7 +19,9 @@
 
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DPNGSNAPS [with SNAPSHOTS, PNG snapshots instead of EPS]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -36,6 +38,9 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
+#include "occupied.h"
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -53,7 +58,7 @@
  *                            SETTINGS 
  ***************************************************************/
 
-#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 
 /***************************************************************
  *                            FUNCTIONS                       
@@ -64,8 +69,6 @@ void openfiles(void);
 void sweep(void); 
 void visualize(int,unsigned long); 
 void states(void); 
-void measures1(void); 
-void measures2(void);
 #ifdef SNAPSHOTS
   void snap(void);  
 #endif
@@ -82,7 +85,9 @@ bool probcheck(double);
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,**neigh,*memory,*measures,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+int *spin,**neigh,*memory,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+schedule measures;
+occupied agents;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2,CONT,LINKS;
 int probperc0,probperc1;
 int hull_perimeter;
@@ -116,7 +121,12 @@ int main(void){
   initialize();
 
   #if(VISUAL==1)
-    printf("set palette defined (-2 'black',-1 '0xff4545', 0 '0xFF0000', 1 '0x81C2EF', 2 '0x0000FF')\n");
+    vis_set_color(-2,0x000000); //black
+    vis_set_color(-1,0xFF4545); //light red
+    vis_set_color(0,0xFF0000); //red
+    vis_set_color(1,0x81C2EF); //light blue
+    vis_set_color(2,0x0000FF); //blue
+    vis_palette_out();
   #endif
   for (int j=0;j<=MCS+1;j++)  {
     #if(VISUAL==1)
@@ -130,13 +140,13 @@ int main(void){
         sweep();
         states();
         hoshen_kopelman();
-        while(measures[k]!=0){
-          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f\n",measures[k],(double)sum/CONT,(double)sumz/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT);
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f\n",sched_time(&measures,k),(double)sum/CONT,(double)sumz/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT);
           k++;
         }           
         break;
       }
-      if (measures[k]==j) {  
+      if (sched_time(&measures,k)==j) {  
         #if(SNAPSHOTS==1)
           snap();   
           k++;        
@@ -167,7 +177,6 @@ void initialize(void) {
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
   memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   zealot = malloc(N*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
@@ -203,6 +212,7 @@ void initialize(void) {
       spin[n] = 0;
     }
   }
+  occ_init(&agents,spin,N);
   #if(VISUAL==0)
     fprintf(fp1,"# Agents: %d\n",CONT);
     fprintf(fp1,"# Time Persistence Zealots Active Clusters Big1 Perc1 Big2 Perc2 qt[0]\n");
@@ -235,9 +245,11 @@ void initialize(void) {
     }
   }
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 
 }
@@ -247,10 +259,9 @@ void initialize(void) {
  ***************************************************************/
 void sweep(void) {
   for (int n=0; n<N; n++) {
-    int site = FRANDOM*N;
+    int site = occ_pick(&agents);
     int E1=0;
     int E2=0;
-    while (spin[site]==0)site = FRANDOM*N;
     for(int i=0; i<4; i++){
       int neighbour = neigh[site][i];
       if(spin[neighbour]==spin[site])E1++;
@@ -284,7 +295,7 @@ void sweep(void) {
         int focalspin = spin[site];
         spin[site]=spin[neighbour];
         spin[neighbour]=focalspin;
-        int focalconf = certainty[site];
+        double focalconf = certainty[site];
         certainty[site]=certainty[neighbour];
         certainty[neighbour]=focalconf;
         int focalz = zealot[site];
@@ -293,6 +304,7 @@ void sweep(void) {
         int focalmemory = memory[site];
         memory[site]=memory[neighbour];
         memory[neighbour]=focalmemory;
+        occ_move(&agents,site,neighbour);
         int INTERFDEPOIS=0;
         if(spin[up[neighbour]]==-spin[neighbour])INTERFDEPOIS++;
         if(spin[right[neighbour]]==-spin[neighbour])INTERFDEPOIS++;
@@ -321,37 +333,6 @@ void states(void) {
     }
   }
 }
- /**************************************************************
- *                       Measures Vector     // Medidas Logarítmicas
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
-    }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
- /**************************************************************
- *                       Measures Vector    // Número de medidas
- *************************************************************/
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
-  }
-  return;
-}
-
 /**************************************************************
  *                      Teste
  *************************************************************/
@@ -367,18 +348,20 @@ bool probcheck(double _ALPHA) {
  *************************************************************/
 void visualize(int _j,unsigned long _seed) {
   int l;
-  printf("pl '-' matrix w image t 'time = %d seed = %ld'\n",_j,_seed);
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
   for(l = N-1; l >= 0; l--) {
     if(spin[l]!=0){  
-      if(zealot[l]==1)printf("%d ", spin[l]+1);
-      else printf("%d ", spin[l]);
+      if(zealot[l]==1)cell[N-1-l]=spin[l]+1;
+      else cell[N-1-l]=spin[l];
     }
     else{
-      printf("%d ", -2);
+      cell[N-1-l]=-2;
     }
-    if( l%L == 0 ) printf("\n");
   }
-  printf("e\n");
+  snprintf(title,sizeof title,"time = %d seed = %ld",_j,_seed);
+  vis_emit(title);
 }
 
 #ifdef SNAPSHOTS
@@ -389,6 +372,7 @@ void visualize(int _j,unsigned long _seed) {
     int l;
     int identifier = 0;
     char teste[100];
+    uint8_t *frame = malloc(N*sizeof(uint8_t));
 
     lat2eps_init(L,L);
     lat2eps_set_color(0,0x00000); //black
@@ -402,22 +386,33 @@ void visualize(int _j,unsigned long _seed) {
 
     for(l=0; l<N; l++) {
       if(spin[l]==1) {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,4);
-        else lat2eps_set_site(l%L,l/L,6);
+        if(certainty[l]>=1)frame[l]=4;
+        else frame[l]=6;
       }
       else {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,5);
-        else lat2eps_set_site(l%L,l/L,7);
+        if(certainty[l]>=1)frame[l]=5;
+        else frame[l]=7;
       } 
     }
 
-    snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+    #ifdef PNGSNAPS
+      const char *ext = "png";
+    #else
+      const char *ext = "eps";
+    #endif
+    snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     while(exists(teste)==true) {
       identifier++;
-      snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+      snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     }
-    lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #ifdef PNGSNAPS
+      lat2eps_gen_raster(teste,frame,L,L,3,LAT2EPS_PNG);
+    #else
+      lat2eps_set_lattice(frame);
+      lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #endif
     lat2eps_release();
+    free(frame);
   }
 #endif
 
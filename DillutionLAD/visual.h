@@ -0,0 +1,198 @@
+/********************************************************************
+***                  Live Visualization Streams                   ***
+***                   Last Modified: 19/10/2026                   ***
+***                                                               ***
+***  visualize() fills a preallocated frame with one small value  ***
+***  per site (in the order the rows are shown) and the frame is  ***
+***  written in one go, in the format chosen at compile time:     ***
+***                                                               ***
+***  -DVSTREAM=0  ASCII matrix for "| gnuplot" (default)          ***
+***  -DVSTREAM=1  gnuplot binary array (one byte per site)        ***
+***  -DVSTREAM=2  raw RGB24 frames for ffmpeg/mpv, e.g.           ***
+***     ./a.out | mpv --demuxer=rawvideo                          ***
+***        --demuxer-rawvideo-w=W --demuxer-rawvideo-h=W          ***
+***        --demuxer-rawvideo-mp-format=rgb24 -                   ***
+***                                                               ***
+***  -DVFPS=30    at most VFPS frames per wall-clock second       ***
+***               (the others are skipped, default: all)          ***
+***  -DVDOWN=2    VDOWN x VDOWN blocks of sites shown as one      ***
+***               pixel with their most frequent value            ***
+***                                                               ***
+***  NBINARY runs (labels 0..N-1) print their own ASCII matrix    ***
+***  and only take VSTREAM=0, VDOWN=1.                            ***
+********************************************************************/
+
+#ifndef VISUAL_H
+#define VISUAL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifndef VSTREAM
+  #define VSTREAM 0
+#endif
+#ifndef VFPS
+  #define VFPS 0
+#endif
+#ifndef VDOWN
+  #define VDOWN 1
+#endif
+
+#if((NBINARY==1)&&((VSTREAM!=0)||(VDOWN>1)))
+  #error "the NBINARY labels do not fit a byte frame: use VSTREAM=0, VDOWN=1"
+#endif
+
+#define VIS_VMIN  (-2)   /* range of the values shown */
+#define VIS_VMAX  (2)
+#define VIS_NV    (VIS_VMAX-VIS_VMIN+1)
+
+/********************************************************************
+***                      Variable Declarations                    ***
+********************************************************************/
+
+int vis_width=0, vis_height=0;        /* frame (sites)             */
+int vis_w=0, vis_h=0;                 /* output (after VDOWN)      */
+int8_t *vis_cell=NULL;                /* frame, filled by caller   */
+int8_t *vis_down=NULL;                /* downsampled frame         */
+char *vis_out=NULL;                   /* output buffer             */
+double vis_last=-1.0;                 /* wall clock of last frame  */
+unsigned int vis_palette[VIS_NV] = { 0x000000, 0xFF4545, 0xFF0000, 0x81C2EF, 0x0000FF };
+
+/********************************************************************
+*                           Palette                                 *
+*                                                                   *
+*  vis_set_color: color (0xRRGGBB) of the value v (VIS_VMIN..VMAX)  *
+*  vis_palette_out: sends the palette to gnuplot (streams 0 and 1); *
+*                   with raw RGB the palette is only used locally   *
+********************************************************************/
+void vis_set_color(int v, unsigned int rgb)
+{
+  if (v < VIS_VMIN || v > VIS_VMAX) return;
+  vis_palette[v-VIS_VMIN] = rgb;
+}
+
+void vis_palette_out(void)
+{
+  int v;
+
+  #if(VSTREAM==2)
+    return;
+  #endif
+  printf("set palette defined (");
+  for (v = VIS_VMIN; v <= VIS_VMAX; v++) {
+    printf("%d '#%06X'%s",v,vis_palette[v-VIS_VMIN],(v<VIS_VMAX)?",":")\n");
+  }
+  printf("set cbrange [%d:%d]\n",VIS_VMIN,VIS_VMAX);
+  fflush(stdout);
+}
+
+/********************************************************************
+*                            Frames                                 *
+*                                                                   *
+*  vis_frame: frame of width x height values to be filled, or NULL  *
+*             if this frame is skipped by the VFPS limit            *
+*  vis_emit: writes the frame filled after vis_frame()              *
+********************************************************************/
+double vis_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+int8_t *vis_frame(int width, int height)
+{
+  if (vis_cell == NULL || width != vis_width || height != vis_height) {
+    free(vis_cell);
+    free(vis_down);
+    free(vis_out);
+    vis_width = width;
+    vis_height = height;
+    vis_w = (width+VDOWN-1)/VDOWN;
+    vis_h = (height+VDOWN-1)/VDOWN;
+    vis_cell = malloc((size_t)width*height);
+    vis_down = malloc((size_t)vis_w*vis_h);
+    /* largest of the formats: "-128 " per value and a newline per row */
+    vis_out = malloc((size_t)vis_w*vis_h*5 + vis_h + 1);
+    if (vis_cell == NULL || vis_down == NULL || vis_out == NULL) {
+      fprintf(stderr,"visual: out of memory for a %dx%d frame\n",width,height);
+      exit(1);
+    }
+  }
+
+  #if(VFPS>0)
+    double now = vis_clock();
+    if (vis_last >= 0.0 && now-vis_last < 1.0/VFPS) return NULL;
+    vis_last = now;
+  #endif
+
+  return vis_cell;
+}
+
+const int8_t *vis_downsample(void)
+{
+  int x,y,i,j,v;
+  int count[VIS_NV];
+
+  if (VDOWN == 1) return vis_cell;
+
+  for (y = 0; y < vis_h; y++) {
+    for (x = 0; x < vis_w; x++) {
+      memset(count,0,sizeof count);
+      for (j = y*VDOWN; j < (y+1)*VDOWN && j < vis_height; j++) {
+        for (i = x*VDOWN; i < (x+1)*VDOWN && i < vis_width; i++) {
+          v = vis_cell[j*vis_width+i];
+          if (v < VIS_VMIN) v = VIS_VMIN;
+          if (v > VIS_VMAX) v = VIS_VMAX;
+          count[v-VIS_VMIN]++;
+        }
+      }
+      for (v = 1, i = 0; v < VIS_NV; v++) if (count[v] > count[i]) i = v;
+      vis_down[y*vis_w+x] = i+VIS_VMIN;
+    }
+  }
+  return vis_down;
+}
+
+void vis_emit(const char *title)
+{
+  const int8_t *f = vis_downsample();
+  size_t n = (size_t)vis_w*vis_h, k;
+  char *p = vis_out;
+  int v;
+
+  #if(VSTREAM==0)
+    printf("pl '-' matrix w image t '%s'\n",title);
+    for (k = 0; k < n; k++) {
+      v = f[k];
+      if (v < 0) { *p++ = '-'; v = -v; }
+      if (v >= 100) *p++ = '0'+v/100;
+      if (v >= 10) *p++ = '0'+(v/10)%10;
+      *p++ = '0'+v%10;
+      *p++ = ' ';
+      if ((k+1)%vis_w == 0) *p++ = '\n';
+    }
+    fwrite(vis_out,1,p-vis_out,stdout);
+    printf("e\n");
+  #elif(VSTREAM==1)
+    printf("pl '-' binary array=(%d,%d) format='%%int8' w image t '%s'\n",vis_w,vis_h,title);
+    fwrite(f,1,n,stdout);
+  #else
+    for (k = 0; k < n; k++) {
+      v = f[k];
+      if (v < VIS_VMIN) v = VIS_VMIN;
+      if (v > VIS_VMAX) v = VIS_VMAX;
+      *p++ = (vis_palette[v-VIS_VMIN]>>16)&255;
+      *p++ = (vis_palette[v-VIS_VMIN]>>8)&255;
+      *p++ = vis_palette[v-VIS_VMIN]&255;
+    }
+    fwrite(vis_out,1,n*3,stdout);
+  #endif
+  fflush(stdout);
+}
+
+#endif
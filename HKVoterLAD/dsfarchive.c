@@ -0,0 +1,190 @@
+/*************************************************************************
+*                  Ensemble archive (.lda) of main outputs               *
+*                             V1.0 19/10/2026                            *
+*************************************************************************/
+
+/***************************************************************
+ *                            USAGE
+ **************************************************************/
+// gcc -O3 dsfarchive.c -o dsfarchive -lm
+// ./dsfarchive add ensemble.lda [-m] files_1.dsf ...  [import runs, -m removes the files]
+// ./dsfarchive list ensemble.lda [L=32 DETA=0.01 ...] [runs and their parameters]
+// ./dsfarchive get ensemble.lda [L=32 DETA=0.01 ...]  > all.dsf
+// ./dsfarchive reindex ensemble.lda                   [rebuild ensemble.lda.idx]
+//
+// Filters: L DETA RESET INTRANS BINARY RHO MOB SEED PROGRAM.
+// "get" writes the outputs one after the other, the same as
+//   printf '%s ' *_1.dsf | xargs cat
+// for the files of those parameters. The simulations append to
+// the archive themselves with -DARCHIVE (see dsfarchive.h).
+
+/***************************************************************
+ *                            INCLUDES
+ **************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "dsfarchive.h"
+
+/***************************************************************
+ *                            FUNCTIONS
+ **************************************************************/
+
+int import(const char *, const char *, bool);
+bool filter(int, char **, arentry *);
+double token(const char *, const char *);
+
+/***************************************************************
+ *                          MAIN PROGRAM
+ **************************************************************/
+int main(int argc, char *argv[]){
+
+  if(argc<3){
+    fprintf(stderr,"Usage: %s add ARCHIVE [-m] files_1.dsf ...\n",argv[0]);
+    fprintf(stderr,"       %s list|get ARCHIVE [KEY=VALUE ...]\n",argv[0]);
+    fprintf(stderr,"       %s reindex ARCHIVE\n",argv[0]);
+    return 1;
+  }
+  const char *arname = argv[2];
+
+  if(strcmp(argv[1],"add")==0){
+    bool move = (argc>3 && strcmp(argv[3],"-m")==0);
+    int added=0;
+    for(int i=(move?4:3); i<argc; i++)added += import(arname,argv[i],move);
+    fprintf(stderr,"%d runs added to %s\n",added,arname);
+    return 0;
+  }
+
+  if(strcmp(argv[1],"reindex")==0){
+    int n = ar_reindex(arname);
+    if(n<0){
+      fprintf(stderr,"%s: can not be read\n",arname);
+      return 1;
+    }
+    fprintf(stderr,"%d runs in %s\n",n,arname);
+    return 0;
+  }
+
+  arentry f,*entries;
+  if(!filter(argc-3,argv+3,&f))return 1;
+  int n = ar_index(arname,&f,&entries);
+  if(n<0){
+    fprintf(stderr,"%s: no index (try reindex)\n",arname);
+    return 1;
+  }
+
+  if(strcmp(argv[1],"list")==0){
+    printf("# L DETA RESET INTRANS BINARY RHO MOB Seed Program Bytes\n");
+    for(int i=0; i<n; i++){
+      arentry *e = &entries[i];
+      printf("%d %g %d %d %d %g %g %lu %.32s %lu\n",e->lsize,e->deta,e->reset,e->intrans,e->binary,e->rho,e->mob,(unsigned long)e->seed,e->program,(unsigned long)e->length);
+    }
+  }
+  else if(strcmp(argv[1],"get")==0){
+    for(int i=0; i<n; i++){
+      char *data = ar_read(arname,&entries[i]);
+      if(data==NULL){
+        fprintf(stderr,"%s: run %d can not be read\n",arname,i);
+        continue;
+      }
+      fwrite(data,1,entries[i].length,stdout);
+      free(data);
+    }
+  }
+  else {
+    fprintf(stderr,"%s: unknown command\n",argv[1]);
+    return 1;
+  }
+
+  free(entries);
+  return 0;
+}
+
+/**************************************************************
+ *       Filter from KEY=VALUE arguments
+ *************************************************************/
+bool filter(int argc, char **argv, arentry *f){
+  *f = ar_entry();
+  f->deta = f->rho = f->mob = NAN;
+
+  for(int i=0; i<argc; i++){
+    char *v = strchr(argv[i],'=');
+    if(v==NULL){
+      fprintf(stderr,"%s: expected KEY=VALUE\n",argv[i]);
+      return false;
+    }
+    *v++ = '\0';
+    if(strcmp(argv[i],"L")==0)f->lsize = atoi(v);
+    else if(strcmp(argv[i],"DETA")==0)f->deta = atof(v);
+    else if(strcmp(argv[i],"RESET")==0)f->reset = atoi(v);
+    else if(strcmp(argv[i],"INTRANS")==0)f->intrans = atoi(v);
+    else if(strcmp(argv[i],"BINARY")==0)f->binary = atoi(v);
+    else if(strcmp(argv[i],"RHO")==0)f->rho = atof(v);
+    else if(strcmp(argv[i],"MOB")==0)f->mob = atof(v);
+    else if(strcmp(argv[i],"SEED")==0)f->seed = strtoul(v,NULL,10);
+    else if(strcmp(argv[i],"PROGRAM")==0)snprintf(f->program,sizeof f->program,"%s",v);
+    else {
+      fprintf(stderr,"%s: unknown parameter\n",argv[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**************************************************************
+ *       Number after "key" in a file name (-1 if absent)
+ *************************************************************/
+double token(const char *name, const char *key){
+  const char *p = strstr(name,key);
+  if(p==NULL)return -1;
+  return atof(p+strlen(key));
+}
+
+/**************************************************************
+ *       Import of an old _1.dsf file
+ *
+ *  Parameters from the header lines, RHO and MOB (not in the
+ *  headers) from the file name.
+ *************************************************************/
+int import(const char *arname, const char *fname, bool move){
+  char line[1024];
+  const char *base = strrchr(fname,'/');
+  arentry e = ar_entry();
+  FILE *fp;
+
+  base = (base==NULL) ? fname : base+1;
+  fp = fopen(fname,"r");
+  if(fp==NULL){
+    fprintf(stderr,"%s: can not be read\n",fname);
+    return 0;
+  }
+  snprintf(e.program,sizeof e.program,"imported");
+  while(fgets(line,sizeof line,fp)!=NULL){
+    if(line[0]!='#')break;
+    if(strncmp(line,"# Generated with: ",18)==0){
+      line[strcspn(line,"\n")] = '\0';
+      snprintf(e.program,sizeof e.program,"%.31s",line+18);
+    }
+    if(strncmp(line,"# Seed:",7)==0)e.seed = strtoul(line+7,NULL,10);
+    if(strncmp(line,"# Linear size:",14)==0)e.lsize = atoi(line+14);
+    if(strncmp(line,"# Irreversible:",15)==0)e.intrans = atoi(line+15);
+    if(strncmp(line,"# Incremento:",13)==0)e.deta = atof(line+13);
+    if(strncmp(line,"# Binary:",9)==0)e.binary = atoi(line+9);
+    if(strncmp(line,"# Reset",7)==0){
+      char *p = strchr(line,':');
+      if(p!=NULL)e.reset = atoi(p+1);
+    }
+  }
+  fclose(fp);
+  e.rho = token(base,"_rho");
+  e.mob = token(base,"_mob");
+
+  if(!ar_append_file(arname,&e,fname)){
+    fprintf(stderr,"%s: can not be added to %s\n",fname,arname);
+    return 0;
+  }
+  if(move)remove(fname);
+  return 1;
+}
@@ -0,0 +1,377 @@
+/********************************************************************
+***                   Ensemble Archive of .dsf runs                ***
+***                     Last Modified: 19/10/2026                  ***
+***                                                                ***
+***  Many runs in one append-only file (ensemble.lda), each one    ***
+***  a record tagged with its parameters, seed and program:        ***
+***                                                                ***
+***     "LADARCH1"                              (once)             ***
+***     "LADR" | size of entry | entry | main output (_1.dsf)      ***
+***     "LADR" | ...                                               ***
+***                                                                ***
+***  and a parameter index (ensemble.lda.idx): "LADAIDX1" and one  ***
+***  fixed size entry per run, with the offset of its output, so   ***
+***  the runs of a (L,DETA) pair are found reading only the index  ***
+***  and then only their own bytes of the archive.                 ***
+***                                                                ***
+***  Writers from many processes append under an exclusive flock   ***
+***  of the archive: record first, index entry after. A writer    ***
+***  killed in between is repaired by the next one (a complete     ***
+***  record is indexed, a partial one is cut off). Readers need    ***
+***  no lock, nothing already written ever changes.                ***
+***                                                                ***
+***  Parameters that do not apply (RHO without dilution, ...) are  ***
+***  stored as -1.                                                 ***
+********************************************************************/
+
+#ifndef DSFARCHIVE_H
+#define DSFARCHIVE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#define AR_MAGIC      "LADARCH1"
+#define AR_IDXMAGIC   "LADAIDX1"
+#define AR_RECMAGIC   "LADR"
+#define AR_IDXEXT     ".idx"
+#define AR_HEADER     8
+#define AR_RECHEADER  (8+sizeof(arentry))
+
+typedef struct {
+  int32_t lsize, reset, intrans, binary;
+  double deta, rho, mob;
+  uint64_t seed;
+  char program[32];     /* generating program (source file)     */
+  uint64_t offset;      /* of the output in the archive         */
+  uint64_t length;      /* of the output                        */
+  uint32_t check;       /* FNV-1a of the output                 */
+  uint32_t pad;
+} arentry;
+
+/********************************************************************
+*                      Entries and filters                          *
+*                                                                   *
+*  ar_entry: entry with every parameter "not applicable"            *
+*  ar_match: 1 if the entry has the parameters of the filter; in a  *
+*            filter -1 (ints), NAN (doubles), seed 0 and an empty   *
+*            program match anything                                 *
+********************************************************************/
+arentry ar_entry(void)
+{
+  arentry e;
+
+  memset(&e,0,sizeof e);
+  e.lsize = e.reset = e.intrans = e.binary = -1;
+  e.deta = e.rho = e.mob = -1;
+  return e;
+}
+
+int ar_same(double a, double b)
+{
+  return fabs(a-b) <= 1e-9*(fabs(a)+fabs(b)+1e-12);
+}
+
+int ar_match(const arentry *e, const arentry *f)
+{
+  if (f->lsize != -1 && f->lsize != e->lsize) return 0;
+  if (f->reset != -1 && f->reset != e->reset) return 0;
+  if (f->intrans != -1 && f->intrans != e->intrans) return 0;
+  if (f->binary != -1 && f->binary != e->binary) return 0;
+  if (!isnan(f->deta) && !ar_same(f->deta,e->deta)) return 0;
+  if (!isnan(f->rho) && !ar_same(f->rho,e->rho)) return 0;
+  if (!isnan(f->mob) && !ar_same(f->mob,e->mob)) return 0;
+  if (f->seed != 0 && f->seed != e->seed) return 0;
+  if (f->program[0] != '\0' && strncmp(f->program,e->program,sizeof e->program) != 0) return 0;
+  return 1;
+}
+
+uint32_t ar_fnv(const void *data, size_t len)
+{
+  const unsigned char *p = data;
+  uint32_t h = 2166136261u;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/********************************************************************
+*                       Low level I/O                               *
+********************************************************************/
+int ar_write(int fd, const void *buf, size_t len)
+{
+  const char *p = buf;
+
+  while (len > 0) {
+    ssize_t w = write(fd,p,len);
+    if (w <= 0) return 0;
+    p += w;
+    len -= w;
+  }
+  return 1;
+}
+
+int ar_pread(int fd, void *buf, size_t len, off_t offset)
+{
+  char *p = buf;
+
+  while (len > 0) {
+    ssize_t r = pread(fd,p,len,offset);
+    if (r <= 0) return 0;
+    p += r;
+    len -= r;
+    offset += r;
+  }
+  return 1;
+}
+
+/********************************************************************
+*                  Record at a position of the archive              *
+*                                                                   *
+*  Return: 1 and its entry if a complete record starts at "pos"     *
+********************************************************************/
+int ar_record(int fd, off_t pos, off_t size, arentry *e)
+{
+  char magic[4];
+  uint32_t esize;
+  char *buf;
+  int ok;
+
+  if (pos + (off_t)AR_RECHEADER > size) return 0;
+  if (!ar_pread(fd,magic,4,pos) || memcmp(magic,AR_RECMAGIC,4) != 0) return 0;
+  if (!ar_pread(fd,&esize,4,pos+4) || esize != sizeof(arentry)) return 0;
+  if (!ar_pread(fd,e,sizeof(arentry),pos+8)) return 0;
+  if (e->offset != (uint64_t)(pos+AR_RECHEADER)) return 0;
+  if (e->offset + e->length > (uint64_t)size) return 0;
+
+  buf = malloc(e->length > 0 ? e->length : 1);
+  if (buf == NULL) return 0;
+  ok = ar_pread(fd,buf,e->length,e->offset) && (ar_fnv(buf,e->length) == e->check);
+  free(buf);
+  return ok;
+}
+
+/********************************************************************
+*                           Repair                                  *
+*                                                                   *
+*  Called with the archive locked. Brings the index up to the end   *
+*  of the archive: complete records after the last indexed one are  *
+*  indexed, anything else after them is cut off.                    *
+*  Return: 1 if archive and index are consistent                    *
+********************************************************************/
+int ar_repair(int fd, int idx)
+{
+  struct stat st;
+  off_t size,isize,pos;
+  arentry e;
+
+  if (fstat(fd,&st) != 0) return 0;
+  size = st.st_size;
+  if (size < AR_HEADER) {
+    if (ftruncate(fd,0) != 0) return 0;
+    if (ftruncate(idx,0) != 0) return 0;
+    return ar_write(fd,AR_MAGIC,AR_HEADER) && ar_write(idx,AR_IDXMAGIC,AR_HEADER);
+  }
+
+  if (fstat(idx,&st) != 0) return 0;
+  isize = st.st_size;
+  if (isize < AR_HEADER) {
+    if (ftruncate(idx,0) != 0 || !ar_write(idx,AR_IDXMAGIC,AR_HEADER)) return 0;
+    isize = AR_HEADER;
+  }
+  isize -= (isize-AR_HEADER) % sizeof(arentry);
+  if (ftruncate(idx,isize) != 0) return 0;
+
+  pos = AR_HEADER;
+  if (isize > AR_HEADER) {
+    if (!ar_pread(idx,&e,sizeof e,isize-sizeof e)) return 0;
+    pos = e.offset + e.length;
+  }
+  if (pos > size) {
+    /* archive shorter than its index: index it again from the start */
+    if (ftruncate(idx,AR_HEADER) != 0) return 0;
+    pos = AR_HEADER;
+  }
+  while (ar_record(fd,pos,size,&e)) {
+    if (!ar_write(idx,&e,sizeof e)) return 0;
+    pos = e.offset + e.length;
+  }
+  if (pos < size && ftruncate(fd,pos) != 0) return 0;
+  return 1;
+}
+
+/********************************************************************
+*                           Append                                  *
+*                                                                   *
+*  ar_append: appends "length" bytes of output with the parameters  *
+*             of *e (offset, length and check are filled here)      *
+*  ar_append_file: same with the contents of the file "fname"       *
+*  Return: 1 on success                                             *
+********************************************************************/
+int ar_append(const char *arname, arentry *e, const char *data, size_t length)
+{
+  char name[400];
+  int fd,idx,ok;
+  off_t end;
+
+  snprintf(name,sizeof name,"%s%s",arname,AR_IDXEXT);
+  fd = open(arname,O_RDWR|O_CREAT|O_APPEND,0644);
+  if (fd < 0) return 0;
+  idx = open(name,O_RDWR|O_CREAT|O_APPEND,0644);
+  if (idx < 0) {
+    close(fd);
+    return 0;
+  }
+  if (flock(fd,LOCK_EX) != 0) {
+    close(idx);
+    close(fd);
+    return 0;
+  }
+
+  ok = ar_repair(fd,idx);
+  end = lseek(fd,0,SEEK_END);
+  if (ok && end >= AR_HEADER) {
+    uint32_t esize = sizeof(arentry);
+    char *rec = malloc(AR_RECHEADER + length);
+
+    e->offset = end + AR_RECHEADER;
+    e->length = length;
+    e->check = ar_fnv(data,length);
+    ok = (rec != NULL);
+    if (ok) {
+      memcpy(rec,AR_RECMAGIC,4);
+      memcpy(rec+4,&esize,4);
+      memcpy(rec+8,e,sizeof(arentry));
+      memcpy(rec+AR_RECHEADER,data,length);
+      ok = ar_write(fd,rec,AR_RECHEADER+length) && (fdatasync(fd) == 0);
+      ok = ok && ar_write(idx,e,sizeof(arentry)) && (fdatasync(idx) == 0);
+    }
+    free(rec);
+  }
+  else ok = 0;
+
+  flock(fd,LOCK_UN);
+  close(idx);
+  close(fd);
+  return ok;
+}
+
+int ar_append_file(const char *arname, arentry *e, const char *fname)
+{
+  FILE *fp = fopen(fname,"rb");
+  char *data;
+  long length;
+  int ok;
+
+  if (fp == NULL) return 0;
+  fseek(fp,0,SEEK_END);
+  length = ftell(fp);
+  fseek(fp,0,SEEK_SET);
+  data = malloc(length > 0 ? length : 1);
+  ok = (data != NULL) && (fread(data,1,length,fp) == (size_t)length);
+  fclose(fp);
+  ok = ok && ar_append(arname,e,data,length);
+  free(data);
+  return ok;
+}
+
+/********************************************************************
+*                           Reader                                  *
+*                                                                   *
+*  ar_index: entries of the runs matching the filter *f (NULL: all) *
+*            in *entries (allocated here, freed by the caller).     *
+*            Return: number of runs, -1 if there is no index        *
+*  ar_read: output of a run, NUL terminated (freed by the caller)   *
+*  ar_has: 1 if a run with the parameters and seed of *e exists     *
+********************************************************************/
+int ar_index(const char *arname, const arentry *f, arentry **entries)
+{
+  char name[400],magic[AR_HEADER];
+  int n=0,size=64;
+  arentry e;
+  FILE *idx;
+
+  snprintf(name,sizeof name,"%s%s",arname,AR_IDXEXT);
+  idx = fopen(name,"rb");
+  if (idx == NULL) return -1;
+  if (fread(magic,1,AR_HEADER,idx) != AR_HEADER || memcmp(magic,AR_IDXMAGIC,AR_HEADER) != 0) {
+    fclose(idx);
+    return -1;
+  }
+
+  *entries = malloc(size*sizeof(arentry));
+  while (fread(&e,sizeof e,1,idx) == 1) {
+    if (f != NULL && !ar_match(&e,f)) continue;
+    if (n == size) {
+      size *= 2;
+      *entries = realloc(*entries,size*sizeof(arentry));
+    }
+    (*entries)[n++] = e;
+  }
+  fclose(idx);
+  return n;
+}
+
+char *ar_read(const char *arname, const arentry *e)
+{
+  char *buf;
+  int fd = open(arname,O_RDONLY);
+
+  if (fd < 0) return NULL;
+  buf = malloc(e->length+1);
+  if (buf != NULL && !ar_pread(fd,buf,e->length,e->offset)) {
+    free(buf);
+    buf = NULL;
+  }
+  if (buf != NULL) buf[e->length] = '\0';
+  close(fd);
+  return buf;
+}
+
+int ar_has(const char *arname, const arentry *e)
+{
+  arentry f = *e, *entries;
+  int n;
+
+  f.program[0] = '\0';
+  n = ar_index(arname,&f,&entries);
+  if (n < 0) return 0;
+  free(entries);
+  return (n > 0);
+}
+
+/********************************************************************
+*                         Index rebuild                             *
+*                                                                   *
+*  Writes the index again from the records of the archive.          *
+*  Return: number of runs, -1 if the archive can not be read        *
+********************************************************************/
+int ar_reindex(const char *arname)
+{
+  char name[400];
+  int fd,idx,n=-1;
+
+  snprintf(name,sizeof name,"%s%s",arname,AR_IDXEXT);
+  fd = open(arname,O_RDWR);
+  if (fd < 0) return -1;
+  idx = open(name,O_RDWR|O_CREAT|O_APPEND,0644);
+  if (idx >= 0 && flock(fd,LOCK_EX) == 0) {
+    if (ftruncate(idx,0) == 0 && ar_repair(fd,idx)) n = (lseek(idx,0,SEEK_END)-AR_HEADER)/sizeof(arentry);
+    flock(fd,LOCK_UN);
+  }
+  if (idx >= 0) close(idx);
+  close(fd);
+  return n;
+}
+
+#endif
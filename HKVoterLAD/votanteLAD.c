@@ -16,10 +16,14 @@
 // -DRESET  [full reset case]
 // -DGRESET [gamma reset case]
 // -DINTRANS [intrans case]
+// -DFROZEN [with INTRANS: zealots, frozen for good, are no longer drawn; only the other sites are, the increments they get from zealot neighbours settled lazily]
 
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DPNGSNAPS [with SNAPSHOTS, PNG snapshots instead of EPS]
+// -DARCHIVE [at the end the run is appended to ensemble.lda and its _1.dsf removed (see dsfarchive.h)]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -36,6 +40,14 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
+#ifdef ARCHIVE
+  #include "dsfarchive.h"
+  #define ARCHIVE_FILE "ensemble.lda"
+#else
+  #define archived(id) false
+#endif
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -68,9 +80,15 @@
   #define BINARY      0
 #endif
 
-#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 #define SIMPLIFIED  1 // 1 --> simplify the algorithm to alpha=beta=1 to avoid calculations
 
+#if(FROZEN==1)
+  #if((INTRANS==0)||(SIMPLIFIED==0))
+    #error "FROZEN needs INTRANS and SIMPLIFIED"
+  #endif
+#endif
+
 /***************************************************************
  *                            FUNCTIONS                       
  **************************************************************/
@@ -78,10 +96,17 @@
 void initialize(void); 
 void openfiles(void); 
 void sweep(void); 
+void interact(int,int);
+#if(FROZEN==1)
+  void liveinit(void);
+  void settle(int);
+  double addeta(double,long);
+  void freeze(int);
+  void bringall(void);
+  long poisson(double);
+#endif
 void visualize(int,unsigned long); 
 void states(void); 
-void measures1(void); 
-void measures2(void);
 #ifdef SNAPSHOTS
   void snap(void);  
 #endif
@@ -92,19 +117,29 @@ void connections(int,int);
 int percolates2d(int);
 bool exists(const char*);
 bool probcheck(double);
+#ifdef ARCHIVE
+  arentry runentry(unsigned long);
+  bool archived(unsigned long);
+  void archive(void);
+#endif
 
 /***************************************************************
  *                         GLOBAL VARIABLES                   
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,**neigh,*memory,*measures,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+int *spin,**neigh,*memory,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+schedule measures;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2;
 int probperc0,probperc1;
 int hull_perimeter;
 char root_name[200];
 unsigned long seed;
 double *certainty;
+#if(FROZEN==1)
+  int *live,*livepos,nlive,*frozen,*pending;
+  double *tlive,tnow;
+#endif
 
 /***************************************************************
  *                          MAIN PROGRAM  
@@ -140,13 +175,13 @@ int main(void){
         states();
         hoshen_kopelman();
         fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",j,(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
-        while(measures[k]!=0){
-          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",measures[k],(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",sched_time(&measures,k),(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
           k++;
         }           
         break;
       }
-      if (measures[k]==j) {  
+      if (sched_time(&measures,k)==j) {  
         #if(SNAPSHOTS==1)
           snap();   
           k++;        
@@ -164,6 +199,9 @@ int main(void){
   #if(SNAPSHOTS==0)
   fclose(fp1);
   #endif
+  #ifdef ARCHIVE
+    archive();
+  #endif
 
 }
 /***************************************************************
@@ -177,7 +215,6 @@ void initialize(void) {
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
   memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   zealot = malloc(N*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
@@ -224,10 +261,16 @@ void initialize(void) {
     down[i] = neigh[i][3];
   }
 
+  #if(FROZEN==1)
+    liveinit();
+  #endif
+
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 
 }
@@ -236,158 +279,295 @@ void initialize(void) {
  *               MCS routine
  ***************************************************************/
 void sweep(void) {
+  #if(FROZEN==1)
+    double tend = floor(tnow) + 1;
+    while(nlive>0){
+      double dt = -log(1-FRANDOM)/nlive;
+      if(tnow+dt>=tend)break;
+      tnow += dt;
+      int site = live[(int)(FRANDOM*nlive)];
+      int dir = FRANDOM*4;
+      int neighbour = neigh[site][dir];
+      settle(site);
+      if(livepos[neighbour]!=-1)settle(neighbour);
+      interact(site,neighbour);
+      if(zealot[site]==1 && livepos[site]!=-1)freeze(site);
+      if(zealot[neighbour]==1 && livepos[neighbour]!=-1)freeze(neighbour);
+    }
+    tnow = tend;
+  #else
+    for (int n=0; n<N; n++) {
+      int site = FRANDOM*N;
+      int dir = FRANDOM*4;
+      interact(site,neigh[site][dir]);
+    }
+  #endif
+}
 
-  for (int n=0; n<N; n++) {
-    int site = FRANDOM*N;
-    int dir = FRANDOM*4;
-    int neighbour = neigh[site][dir];
+/****************************************************************
+ *               Pair interaction (focal site, neighbour)
+ ***************************************************************/
+void interact(int site, int neighbour) {
+  #if(SIMPLIFIED==1)
+    if(spin[site]!=spin[neighbour]) {
+      if(zealot[site] == 0){
+
+        #if(NBINARY==0)
+          memory[site]=1;
+          qt[(spin[site] + 1 )/2]--;
+          spin[site] = spin[neighbour];
+          qt[(spin[neighbour] + 1 )/2]++;
+        #else
+          memory[spin[site]]--;
+          spin[site] = spin[neighbour];
+          memory[spin[site]]++;
+        #endif
+
+      }
+
+      certainty[neighbour] += DETA;
 
-    #if(SIMPLIFIED==1)
-      if(spin[site]!=spin[neighbour]) {
-        if(zealot[site] == 0){
+      #if(RESET==2)
+        certainty[site] = certainty[site]/GAMMA;
+      #endif
+      #if(RESET==1)
+        certainty[site] = 0;
+      #endif
+      #if(RESET==0)
+        certainty[site] -= DETA;
+      #endif     
+
+      #if(INTRANS==0)
+        if(certainty[site]<=THRESHOLD)zealot[site]=0;
+      #endif
+
+      if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+    }
+    else{
+      certainty[site] += DETA;
+      certainty[neighbour] += DETA;
+      if(certainty[site]>=THRESHOLD)zealot[site]=1;
+      if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+    }
+  #else
+    bool acc1 = probcheck(ALPHA);
+    bool acc2 = probcheck(BETA);
+    if(spin[site]!=spin[neighbour]) {
+      if(zealot[site] == 0){
+        if(acc1==true) {
 
           #if(NBINARY==0)
             memory[site]=1;
-            qt[(spin[site] + 1 )/2]--;
             spin[site] = spin[neighbour];
-            qt[(spin[neighbour] + 1 )/2]++;
           #else
             memory[spin[site]]--;
             spin[site] = spin[neighbour];
             memory[spin[site]]++;
           #endif
 
-        }
+          #if(RESET==2)
+            certainty[site] = certainty[site]/GAMMA;
+          #endif
 
-        certainty[neighbour] += DETA;
+          #if(RESET==1)
+            certainty[site] = 0;
+          #endif
 
-        #if(RESET==2)
-          certainty[site] = certainty[site]/GAMMA;
-        #endif
-        #if(RESET==1)
-          certainty[site] = 0;
-        #endif
-        #if(RESET==0)
-          certainty[site] -= DETA;
-        #endif     
+          #if(RESET==0)
+            certainty[site] -= DETA;
+          #endif
 
-        #if(INTRANS==0)
-          if(certainty[site]<=THRESHOLD)zealot[site]=0;
-        #endif
+          certainty[neighbour] += DETA;
+          #if(INTRANS==0)
+            if(certainty[site]<=THRESHOLD)zealot[site]=0;
+          #endif
+          if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
 
-        if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
-        continue;
-      }
-      else{
-        certainty[site] += DETA;
-        certainty[neighbour] += DETA;
-        if(certainty[site]>=THRESHOLD)zealot[site]=1;
-        if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
-        continue;
-      }
-    #else
-      bool acc1 = probcheck(ALPHA);
-      bool acc2 = probcheck(BETA);
-      if(spin[site]!=spin[neighbour]) {
-        if(zealot[site] == 0){
-          if(acc1==true) {
-
-            #if(NBINARY==0)
-              memory[site]=1;
-              spin[site] = spin[neighbour];
-            #else
-              memory[spin[site]]--;
-              spin[site] = spin[neighbour];
-              memory[spin[site]]++;
-            #endif
-
-            #if(RESET==2)
-              certainty[site] = certainty[site]/GAMMA;
-            #endif
-
-            #if(RESET==1)
-              certainty[site] = 0;
-            #endif
-
-            #if(RESET==0)
-              certainty[site] -= DETA;
-            #endif
-
-            certainty[neighbour] += DETA;
-            #if(INTRANS==0)
-              if(certainty[site]<=THRESHOLD)zealot[site]=0;
-            #endif
-            if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
-
-          }
-          else{
-            certainty[site] += DETA;
-            certainty[neighbour] -= DETA;
-
-            #if(INTRANS==0)
-              if(certainty[neighbour]<=THRESHOLD)zealot[neighbour]=0;
-            #endif
-
-            if(certainty[site]>=THRESHOLD)zealot[site]=1;
-          }
         }
+        else{
+          certainty[site] += DETA;
+          certainty[neighbour] -= DETA;
 
-        else {
-          if (acc2==true) {
+          #if(INTRANS==0)
+            if(certainty[neighbour]<=THRESHOLD)zealot[neighbour]=0;
+          #endif
 
-            certainty[neighbour] += DETA;
+          if(certainty[site]>=THRESHOLD)zealot[site]=1;
+        }
+      }
 
-            #if(RESET==2)
-              certainty[site] = certainty[site]/GAMMA;
-            #endif
+      else {
+        if (acc2==true) {
 
-            #if(RESET==1)
-              certainty[site] = 0;
-            #endif
+          certainty[neighbour] += DETA;
 
-            #if(RESET==0)
-              certainty[site] -= DETA;
-            #endif
-            
-            #if(INTRANS==0)
-              if(certainty[site]<=THRESHOLD)zealot[site]=0;
-            #endif
-            if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+          #if(RESET==2)
+            certainty[site] = certainty[site]/GAMMA;
+          #endif
 
-          }
+          #if(RESET==1)
+            certainty[site] = 0;
+          #endif
 
-          else  {
+          #if(RESET==0)
             certainty[site] -= DETA;
-            certainty[neighbour] += DETA;
+          #endif
+          
+          #if(INTRANS==0)
+            if(certainty[site]<=THRESHOLD)zealot[site]=0;
+          #endif
+          if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+
+        }
 
-            #if(INTRANS==0)
-              if(certainty[site]<=THRESHOLD)zealot[site]=0;
-            #endif
+        else  {
+          certainty[site] -= DETA;
+          certainty[neighbour] += DETA;
 
-            if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+          #if(INTRANS==0)
+            if(certainty[site]<=THRESHOLD)zealot[site]=0;
+          #endif
 
-          }
+          if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
 
         }
 
       }
 
-      else{
-        certainty[site] += DETA;
-        certainty[neighbour] += DETA;
-        if(certainty[site]>=THRESHOLD)zealot[site]=1;
-        if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
-        continue;
+    }
+
+    else{
+      certainty[site] += DETA;
+      certainty[neighbour] += DETA;
+      if(certainty[site]>=THRESHOLD)zealot[site]=1;
+      if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+    }
+  #endif    
+}
+
+#if(FROZEN==1)
+/****************************************************************
+ *               Live sites (FROZEN)
+ *
+ * With INTRANS a zealot never flips again and its own certainty
+ * no longer matters, so only the other ("live") sites are drawn,
+ * each at rate 1 (exponential times of mean 1/nlive between
+ * draws, as for N draws per MCS at large N). What a zealot still
+ * does, +DETA to the neighbour it picks, reaches a live site with
+ * frozen[] zealot neighbours as a Poisson number of increments,
+ * of mean frozen/4 per MCS, settled up to tnow whenever the site
+ * takes part in a draw, before a neighbour freezes (which changes
+ * the rate) and before measurements. The certainty of a zealot
+ * is kept at the value it froze with.
+ ***************************************************************/
+void liveinit(void) {
+  live = malloc(N*sizeof(int));
+  livepos = malloc(N*sizeof(int));
+  frozen = malloc(N*sizeof(int));
+  pending = malloc(N*sizeof(int));
+  tlive = malloc(N*sizeof(double));
+  for (int i=0; i<N; i++) {
+    live[i] = i;
+    livepos[i] = i;
+    frozen[i] = 0;
+    tlive[i] = 0;
+  }
+  nlive = N;
+  tnow = 0;
+}
+
+void settle(int _site) {
+  if(frozen[_site]>0){
+    long n = poisson(0.25*frozen[_site]*(tnow-tlive[_site]));
+    if(n>0){
+      certainty[_site] = addeta(certainty[_site],n);
+      if(certainty[_site]>=THRESHOLD)zealot[_site]=1;
+    }
+  }
+  tlive[_site] = tnow;
+}
+
+/* n increments of DETA, one at a time up to THRESHOLD as the draws
+   would add them (ten 0.1 make 0.9999999999999999, not 1), the rest
+   at once */
+double addeta(double c, long n) {
+  while(n>0 && c<THRESHOLD){
+    c += DETA;
+    n--;
+  }
+  return c + n*DETA;
+}
+
+/* _site became a zealot: out of the live sites, and so may be some of its neighbours */
+void freeze(int _site) {
+  int top = 0;
+  pending[top++] = _site;
+  while(top>0){
+    int v = pending[--top];
+    int a = livepos[v];
+    live[a] = live[--nlive];
+    livepos[live[a]] = a;
+    livepos[v] = -1;
+    for(int j=0; j<4; j++){
+      int w = neigh[v][j];
+      if(livepos[w]==-1)continue;
+      settle(w);
+      frozen[w]++;
+      if(zealot[w]==1){
+        int known = 0;
+        for(int p=0; p<top; p++)if(pending[p]==w)known = 1;
+        if(known==0)pending[top++] = w;
       }
-    #endif    
+    }
+  }
+}
 
+void bringall(void) {
+  for (int a=nlive-1; a>=0; a--) {
+    if(a>=nlive)continue;
+    int v = live[a];
+    settle(v);
+    if(zealot[v]==1)freeze(v);
   }
 }
 
+/****************************************************************
+ *               Poisson numbers
+ *
+ *  Inversion for small means, transformed rejection (PTRS,
+ *  Hormann 1993) for the others.
+ ***************************************************************/
+long poisson(double mu) {
+  if(mu<10){
+    double p = exp(-mu), f = p, u = FRANDOM;
+    long n = 0;
+    while(u>f && n<1000){
+      n++;
+      p *= mu/n;
+      f += p;
+    }
+    return n;
+  }
+  double slam = sqrt(mu), loglam = log(mu);
+  double b = 0.931 + 2.53*slam, a = -0.059 + 0.02483*b;
+  double invalpha = 1.1239 + 1.1328/(b-3.4), vr = 0.9277 - 3.6224/(b-2);
+  for(;;){
+    double u = FRANDOM-0.5, v = FRANDOM, us = 0.5-fabs(u);
+    long k = (long)floor((2*a/us + b)*u + mu + 0.43);
+    if(us>=0.07 && v<=vr)return k;
+    if(k<0 || (us<0.013 && v>us))continue;
+    if(log(v) + log(invalpha) - log(a/(us*us)+b) <= -mu + k*loglam - lgamma(k+1))return k;
+  }
+}
+#endif
+
 /****************************************************************
  *               Check states numbers
  ***************************************************************/
 void states(void) {
+  #if(FROZEN==1)
+    bringall();
+  #endif
   #if(NBINARY==0)  
     sum=N;
   #else
@@ -407,37 +587,6 @@ void states(void) {
     if (spin[down[i]]!=spin[i]) activesum++;
   }
 }
- /**************************************************************
- *                       Measures Vector     // Medidas Logarítmicas
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
-    }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
- /**************************************************************
- *                       Measures Vector    // Número de medidas
- *************************************************************/
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
-  }
-  return;
-}
-
 /**************************************************************
  *                      Teste
  *************************************************************/
@@ -452,19 +601,32 @@ bool probcheck(double _ALPHA) {
  *                       Vizualização                   
  *************************************************************/
 void visualize(int _j,unsigned long _seed) {
+  #if(FROZEN==1)
+    bringall();
+  #endif
   int l;
-  printf("pl '-' matrix w image t 'time = %d seed = %ld'\n",_j,_seed);
-  for(l = N-1; l >= 0; l--) {
-    #if(NBINARY==0)
-      if(zealot[l]==1)printf("%d ", spin[l]+1);
-      else printf("%d ", spin[l]);
-    #else
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
+  #if(NBINARY==0)
+    for(l = N-1; l >= 0; l--) {
+      if(zealot[l]==1)cell[N-1-l]=spin[l]+1;
+      else cell[N-1-l]=spin[l];
+    }
+  #endif
+  snprintf(title,sizeof title,"time = %d seed = %ld",_j,_seed);
+  #if(NBINARY==0)
+    vis_emit(title);
+  #else
+    /* the labels (0..N-1) do not fit the byte frame: plain matrix */
+    printf("pl '-' matrix w image t '%s'\n",title);
+    for(l = N-1; l >= 0; l--) {
       if(zealot[l]==1)printf("%d ", -spin[l]);
       else printf("%d ", spin[l]);
-    #endif
-    if( l%L == 0 ) printf("\n");
-  }
-  printf("e\n");
+      if( l%L == 0 ) printf("\n");
+    }
+    printf("e\n");
+  #endif
 }
 
 #ifdef SNAPSHOTS
@@ -472,9 +634,13 @@ void visualize(int _j,unsigned long _seed) {
  *                       Snapshots                   
  *************************************************************/
   void snap(void) {
+    #if(FROZEN==1)
+      bringall();
+    #endif
     int l;
     int identifier = 0;
     char teste[100];
+    uint8_t *frame = malloc(N*sizeof(uint8_t));
 
     lat2eps_init(L,L);
     lat2eps_set_color(0,0x00000); //black
@@ -488,22 +654,33 @@ void visualize(int _j,unsigned long _seed) {
     
     for(l=0; l<N; l++) {
       if(spin[l]==1) {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,4);
-        else lat2eps_set_site(l%L,l/L,6);
+        if(certainty[l]>=1)frame[l]=4;
+        else frame[l]=6;
       }
       else {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,5);
-        else lat2eps_set_site(l%L,l/L,7);
+        if(certainty[l]>=1)frame[l]=5;
+        else frame[l]=7;
       } 
     }
 
-    snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+    #ifdef PNGSNAPS
+      const char *ext = "png";
+    #else
+      const char *ext = "eps";
+    #endif
+    snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     while(exists(teste)==true) {
       identifier++;
-      snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+      snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     }
-    lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #ifdef PNGSNAPS
+      lat2eps_gen_raster(teste,frame,L,L,3,LAT2EPS_PNG);
+    #else
+      lat2eps_set_lattice(frame);
+      lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #endif
     lat2eps_release();
+    free(frame);
   }
 #endif
 
@@ -696,7 +873,7 @@ void openfiles(void) {
  unsigned long identifier = seed;
   #if(DEBUG==0)
     sprintf(teste,"%s_sd%ld_1.dsf",root_name,identifier);
-    while(exists(teste)==true) {
+    while((exists(teste)==true)||(archived(identifier)==true)) {
       identifier+=2;
       sprintf(teste,"%s_sd%ld_1.dsf",root_name,identifier);
     }
@@ -719,4 +896,38 @@ void openfiles(void) {
 
   return;
 
-}
\ No newline at end of file
+}
+
+#ifdef ARCHIVE
+/**************************************************************
+ *               Ensemble archive
+ *************************************************************/
+
+arentry runentry(unsigned long _seed) {
+  arentry e = ar_entry();
+  const char *program = strrchr(__FILE__,'/');
+
+  e.lsize = L;
+  e.deta = DETA;
+  e.reset = RESET;
+  e.intrans = INTRANS;
+  e.binary = BINARY;
+  e.seed = _seed;
+  snprintf(e.program,sizeof e.program,"%s",(program==NULL)?__FILE__:program+1);
+  return e;
+}
+
+bool archived(unsigned long _seed) {
+  arentry e = runentry(_seed);
+  return (ar_has(ARCHIVE_FILE,&e)==1);
+}
+
+void archive(void) {
+  char output_file1[300];
+  arentry e = runentry(seed);
+
+  sprintf(output_file1,"%s_sd%ld_1.dsf",root_name,seed);
+  if(ar_append_file(ARCHIVE_FILE,&e,output_file1)==1)remove(output_file1);
+  else fprintf(stderr,"%s can not be added to %s, kept\n",output_file1,ARCHIVE_FILE);
+}
+#endif
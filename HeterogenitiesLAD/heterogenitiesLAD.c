@@ -19,7 +19,10 @@
 
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DPNGSNAPS [with SNAPSHOTS, PNG snapshots instead of EPS]
+// -DCHECKPOINT=600 [checkpoint every 600 s of wall time, a new run of the same parameters resumes a dead one (see checkpoint.h)]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -36,6 +39,14 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
+#ifdef CHECKPOINT
+  #if((VISUAL==1)||(SNAPSHOTS==1))
+    #error "CHECKPOINT needs the output files (no VISUAL or SNAPSHOTS)"
+  #endif
+  #include "checkpoint.h"
+#endif
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -68,7 +79,7 @@
   #define BINARY      0
 #endif
 
-#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 #define SIMPLIFIED  1 // 1 --> simplify the algorithm to alpha=beta=1 to avoid calculations
 
 /***************************************************************
@@ -80,8 +91,6 @@ void openfiles(void);
 void sweep(void); 
 void visualize(int,unsigned long); 
 void states(void); 
-void measures1(void); 
-void measures2(void);
 #ifdef SNAPSHOTS
   void snap(void);  
 #endif
@@ -92,19 +101,25 @@ void connections(int,int);
 int percolates2d(int);
 bool exists(const char*);
 bool probcheck(double);
+#ifdef CHECKPOINT
+  void checkpoint(int,int);
+  void restore(int*,int*);
+#endif
 
 /***************************************************************
  *                         GLOBAL VARIABLES                   
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,**neigh,*memory,*measures,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+int *spin,**neigh,*memory,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+schedule measures;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2;
 int probperc0,probperc1;
 int hull_perimeter;
 char root_name[200];
 unsigned long seed;
 double *certainty;
+int resumed=0;
 
 /***************************************************************
  *                          MAIN PROGRAM  
@@ -129,24 +144,31 @@ int main(void){
 
 
   int k=0;
+  int j0=0;
   initialize();
+  #ifdef CHECKPOINT
+    if(resumed==1)restore(&j0,&k);
+  #endif
 
-  for (int j=0;j<=MCS+1;j++)  {
+  for (int j=j0;j<=MCS+1;j++)  {
     #if(VISUAL==1)
       visualize(j,seed);
       sweep();
     #else
+      #ifdef CHECKPOINT
+        if(ck_due(CHECKPOINT))checkpoint(j,k);
+      #endif
       if( ( qt[0]==0 ) | ( qt[1]==0 ) ){
         states();
         hoshen_kopelman();
         fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",j,(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
-        while(measures[k]!=0){
-          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",measures[k],(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",sched_time(&measures,k),(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
           k++;
         }           
         break;
       }
-      if (measures[k]==j) {  
+      if (sched_time(&measures,k)==j) {  
         #if(SNAPSHOTS==1)
           snap();   
           k++;        
@@ -164,6 +186,9 @@ int main(void){
   #if(SNAPSHOTS==0)
   fclose(fp1);
   #endif
+  #ifdef CHECKPOINT
+    ck_done(root_name,seed);
+  #endif
 
 }
 /***************************************************************
@@ -177,7 +202,6 @@ void initialize(void) {
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
   memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   zealot = malloc(N*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
@@ -225,9 +249,11 @@ void initialize(void) {
   }
 
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 
 }
@@ -407,37 +433,6 @@ void states(void) {
     if (spin[down[i]]!=spin[i]) activesum++;
   }
 }
- /**************************************************************
- *                       Measures Vector     // Medidas Logarítmicas
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
-    }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
- /**************************************************************
- *                       Measures Vector    // Número de medidas
- *************************************************************/
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
-  }
-  return;
-}
-
 /**************************************************************
  *                      Teste
  *************************************************************/
@@ -453,18 +448,28 @@ bool probcheck(double _ALPHA) {
  *************************************************************/
 void visualize(int _j,unsigned long _seed) {
   int l;
-  printf("pl '-' matrix w image t 'time = %d seed = %ld'\n",_j,_seed);
-  for(l = N-1; l >= 0; l--) {
-    #if(NBINARY==0)
-      if(zealot[l]==1)printf("%d ", spin[l]+1);
-      else printf("%d ", spin[l]);
-    #else
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
+  #if(NBINARY==0)
+    for(l = N-1; l >= 0; l--) {
+      if(zealot[l]==1)cell[N-1-l]=spin[l]+1;
+      else cell[N-1-l]=spin[l];
+    }
+  #endif
+  snprintf(title,sizeof title,"time = %d seed = %ld",_j,_seed);
+  #if(NBINARY==0)
+    vis_emit(title);
+  #else
+    /* the labels (0..N-1) do not fit the byte frame: plain matrix */
+    printf("pl '-' matrix w image t '%s'\n",title);
+    for(l = N-1; l >= 0; l--) {
       if(zealot[l]==1)printf("%d ", -spin[l]);
       else printf("%d ", spin[l]);
-    #endif
-    if( l%L == 0 ) printf("\n");
-  }
-  printf("e\n");
+      if( l%L == 0 ) printf("\n");
+    }
+    printf("e\n");
+  #endif
 }
 
 #ifdef SNAPSHOTS
@@ -475,6 +480,7 @@ void visualize(int _j,unsigned long _seed) {
     int l;
     int identifier = 0;
     char teste[100];
+    uint8_t *frame = malloc(N*sizeof(uint8_t));
 
     lat2eps_init(L,L);
     lat2eps_set_color(0,0x00000); //black
@@ -488,22 +494,33 @@ void visualize(int _j,unsigned long _seed) {
 
     for(l=0; l<N; l++) {
       if(spin[l]==1) {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,4);
-        else lat2eps_set_site(l%L,l/L,6);
+        if(certainty[l]>=1)frame[l]=4;
+        else frame[l]=6;
       }
       else {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,5);
-        else lat2eps_set_site(l%L,l/L,7);
+        if(certainty[l]>=1)frame[l]=5;
+        else frame[l]=7;
       } 
     }
 
-    snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+    #ifdef PNGSNAPS
+      const char *ext = "png";
+    #else
+      const char *ext = "eps";
+    #endif
+    snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     while(exists(teste)==true) {
       identifier++;
-      snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+      snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     }
-    lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #ifdef PNGSNAPS
+      lat2eps_gen_raster(teste,frame,L,L,3,LAT2EPS_PNG);
+    #else
+      lat2eps_set_lattice(frame);
+      lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #endif
     lat2eps_release();
+    free(frame);
   }
 #endif
 
@@ -694,9 +711,12 @@ void openfiles(void) {
   #endif
 
  unsigned long identifier = seed;
+  #ifdef CHECKPOINT
+    resumed = ck_claim(root_name,&identifier);
+  #endif
   #if(DEBUG==0)
     sprintf(teste,"%s_sd%ld_1.dsf",root_name,identifier);
-    while(exists(teste)==true) {
+    while((resumed==0)&&(exists(teste)==true)) {
       identifier+=2;
       sprintf(teste,"%s_sd%ld_1.dsf",root_name,identifier);
     }
@@ -704,8 +724,16 @@ void openfiles(void) {
   sprintf(teste,"%s_sd%ld",root_name,identifier);
   seed=identifier;
 
+  #ifdef CHECKPOINT
+    if(resumed==0)ck_lock(root_name,seed);
+  #endif
+
   sprintf(output_file1,"%s_1.dsf",teste);
-  fp1 = fopen(output_file1,"w");
+  fp1 = fopen(output_file1,(resumed==1)?"r+":"w");
+  if(fp1==NULL){
+    fprintf(stderr,"%s can not be opened\n",output_file1);
+    exit(1);
+  }
   fprintf(fp1,"# LAD Voter Model 2D Main Output\n");
   fprintf(fp1,"# Seed: %ld\n",seed);
   fprintf(fp1,"# Linear size: %d\n",L);
@@ -719,4 +747,56 @@ void openfiles(void) {
 
   return;
 
-}
\ No newline at end of file
+}
+
+#ifdef CHECKPOINT
+/**************************************************************
+ *               Checkpoint / restart routines
+ *************************************************************/
+
+int ckstate(ckblock *b, int *j, int *k, long *length) {
+  int nb=0;
+  b[nb++] = (ckblock)CK_VAR(seed);
+  b[nb++] = (ckblock){"j",j,sizeof(int)};
+  b[nb++] = (ckblock){"k",k,sizeof(int)};
+  b[nb++] = (ckblock){"length1",length,sizeof(long)};
+  b[nb++] = (ckblock)CK_ARRAY(spin,N);
+  b[nb++] = (ckblock)CK_ARRAY(certainty,N);
+  b[nb++] = (ckblock)CK_ARRAY(zealot,N);
+  b[nb++] = (ckblock)CK_ARRAY(memory,N);
+  #if(NBINARY==0)
+    b[nb++] = (ckblock)CK_ARRAY(qt,2);
+  #else
+    b[nb++] = (ckblock)CK_ARRAY(qt,N);
+  #endif
+  b[nb++] = (ckblock)CK_VAR(ira);
+  b[nb++] = (ckblock)CK_VAR(ip);
+  b[nb++] = (ckblock)CK_VAR(ip1);
+  b[nb++] = (ckblock)CK_VAR(ip2);
+  b[nb++] = (ckblock)CK_VAR(ip3);
+  return nb;
+}
+
+void checkpoint(int j, int k) {
+  ckblock b[16];
+  long length;
+
+  fflush(fp1);
+  fsync(fileno(fp1));
+  length = ftell(fp1);
+  if(ck_save(root_name,seed,b,ckstate(b,&j,&k,&length))==0){
+    fprintf(stderr,"checkpoint of %s_sd%ld can not be written\n",root_name,seed);
+  }
+}
+
+void restore(int *j, int *k) {
+  ckblock b[16];
+  long length;
+
+  if(ck_load(root_name,seed,b,ckstate(b,j,k,&length))==0){
+    fprintf(stderr,"checkpoint of %s_sd%ld is corrupted or from another build\n",root_name,seed);
+    exit(1);
+  }
+  ck_truncate(fp1,length);
+}
+#endif
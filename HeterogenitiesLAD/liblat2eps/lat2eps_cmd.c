@@ -101,6 +101,16 @@ void process_embedded_command(char *buffer)
 			lat2eps_set_color(coloridx, pal);						
 		}
 
+	} else if (!strncasecmp(buffer, "ENC", 3) && strchr(separators, buffer[3])) {
+
+		/* Encoder command (0 for row runs only, 1 for rectangles) */
+
+		unsigned int ntk = parse_buffer(buffer + 4, 1, separators, tokens, NULL);
+
+		if (ntk == 1) {
+			lat2eps_set_encoder(atoi(tokens[0]));
+		}
+
 	} else if (!strncasecmp(buffer, "PAL", 3) && strchr(separators, buffer[3])) {
 	
 		/* Palette command (changes the full palette) */
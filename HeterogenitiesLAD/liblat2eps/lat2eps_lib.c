@@ -18,15 +18,8 @@
 #include "lat2eps.h"
 
 
-static int *lattice = NULL;
-static unsigned int defpalette[] = { 0xFFFFFF, 0x000000, 0xBE2633, 0x44891A, 0x005784, 0xF7E26B, 0xA46422, 0xB2DCEF, 0xEB8931, 0x1B2632, 0xE06F8B, 0x493C2B, 0x2F484E, 0x9D9D9D, 0xA3CE27, 0x31A2F2 };
-static unsigned int palette[LAT2EPS_MAXQ];
-
-static unsigned int maxwidth = 0;
-static unsigned int maxheight = 0;
-static unsigned int txtcounter = 0;
-
-static struct {
+/* Text entry of a context. */
+struct lat2eps_text {
 	float x;
 	float y;
 	float ax;
@@ -35,37 +28,74 @@ static struct {
 	unsigned int size;
 	unsigned int color;
 	char *text;
-} textentry[LAT2EPS_MAXT];
+};
+
+/* Lattice, palette and text entries of one graphic. Nothing else in the library is shared, so distinct contexts can be used from distinct threads. */
+struct lat2eps_ctx {
+	int *lattice;
+	unsigned int maxwidth;
+	unsigned int maxheight;
+	unsigned int palette[LAT2EPS_MAXQ];
+	char palps[LAT2EPS_MAXQ][64];             /* PostScript definition of each color ("/Cn { r g b setrgbcolor } def") */
+	unsigned char palcached[LAT2EPS_MAXQ];    /* palps[n] is up to date with palette[n] */
+	int encoder;
+	unsigned int txtcounter;
+	struct lat2eps_text textentry[LAT2EPS_MAXT];
+};
+
+static unsigned int defpalette[] = { 0xFFFFFF, 0x000000, 0xBE2633, 0x44891A, 0x005784, 0xF7E26B, 0xA46422, 0xB2DCEF, 0xEB8931, 0x1B2632, 0xE06F8B, 0x493C2B, 0x2F484E, 0x9D9D9D, 0xA3CE27, 0x31A2F2 };
+
+/* Context behind the original (non-reentrant) functions. */
+static lat2eps_ctx defctx;
+static int definit = 0;
+
+
+/* Deflate window (32k) and hash table used by the PNG encoder. */
+#define DEFL_WSIZE   32768
+#define DEFL_HBITS   15
+#define DEFL_CHAIN   32
+#define DEFL_MAXLEN  258
+
+/* Bit writer of the deflate stream (LSB first). */
+typedef struct {
+	uint8_t *out;
+	size_t pos;
+	uint32_t bitbuf;
+	unsigned int bitcnt;
+} bitwriter;
 
 
 /* Private functions */
-static void release_resources();
-static void gen_eps_prolog(FILE *f, unsigned int width, unsigned int height, unsigned int scale, unsigned int border);
-static void gen_eps_epilog(FILE *f, unsigned int width, unsigned int height, unsigned int scale, unsigned int border);
-static void gen_eps_lattice(FILE *f, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height);
+static lat2eps_ctx *default_ctx();
+static void init_ctx(lat2eps_ctx *ctx);
+static void init_palette(lat2eps_ctx *ctx);
+static void release_resources(lat2eps_ctx *ctx);
+static void gen_eps_prolog(lat2eps_ctx *ctx, FILE *f, unsigned int width, unsigned int height, unsigned int scale, unsigned int border, const unsigned char *used);
+static void gen_eps_epilog(const lat2eps_ctx *ctx, FILE *f, unsigned int width, unsigned int height, unsigned int scale, unsigned int border);
+static void gen_eps_lattice(const lat2eps_ctx *ctx, FILE *f, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height);
+static int gen_eps_rects(const lat2eps_ctx *ctx, FILE *f, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height);
+static int gen_ppm(const lat2eps_ctx *ctx, FILE *f, const uint8_t *buffer, unsigned int width, unsigned int height, unsigned int scale);
+static int gen_png(const lat2eps_ctx *ctx, FILE *f, const uint8_t *buffer, unsigned int width, unsigned int height, unsigned int scale);
+static size_t deflate_fixed(const uint8_t *in, size_t n, uint8_t *out);
 
 
 /* Initializes the lattice resources. */
 int lat2eps_init(unsigned int width, unsigned int height)
 {
-	unsigned int i;
+	lat2eps_ctx *ctx = default_ctx();
 
-	release_resources();
+	release_resources(ctx);
 	
 	if ((width > LAT2EPS_MAXL) || (height > LAT2EPS_MAXL)) {
 		return 0;
 	}
 
-	maxwidth = width;
-	maxheight = height;
-	txtcounter = 0;
+	ctx->maxwidth = width;
+	ctx->maxheight = height;
 	
-	lattice = (int *)calloc((size_t)(width * height), sizeof(int));
+	ctx->lattice = (int *)calloc((size_t)(width * height), sizeof(int));
 
-	/* Initializes the initial palette table by repeating the colors from the default palette table. */
-	for (i = 0; i < LAT2EPS_MAXQ; ++i) {
-		palette[i] = defpalette[i % (sizeof(defpalette) / sizeof(defpalette[0]))];
-	}
+	init_palette(ctx);
 
 	return 1;
 }
@@ -74,24 +104,136 @@ int lat2eps_init(unsigned int width, unsigned int height)
 /* Releases the lattice resources. */
 void lat2eps_release()
 {
-	release_resources();
+	release_resources(default_ctx());
 }
 
 
 /* Sets the lattice site with coordinates x,y to value s. */
 void lat2eps_set_site(unsigned int x, unsigned int y, int s)
 {
-	if ((x < maxwidth) && (y < maxheight)) {
-		lattice[y * maxwidth + x] = s;
-	}
+	lat2eps_ctx_set_site(default_ctx(), x, y, s);
+}
+
+
+/* Copies a full lattice (one byte per site) from a caller-owned buffer. */
+void lat2eps_set_lattice(const uint8_t *buffer)
+{
+	lat2eps_ctx_set_lattice(default_ctx(), buffer);
 }
 
 
 /* Gets the value of the lattice site with coordinates x,y. */
 int lat2eps_get_site(unsigned int x, unsigned int y)
 {
-	if ((x < maxwidth) && (y < maxheight)) {
-		return lattice[y * maxwidth + x];
+	return lat2eps_ctx_get_site(default_ctx(), x, y);
+}
+
+
+/* Sets a color index to a palette entry defined in the 0xRRGGBB format */
+void lat2eps_set_color(unsigned int index, unsigned int pal)
+{
+	lat2eps_ctx_set_color(default_ctx(), index, pal);
+}
+
+
+/* Gets the palette definition associated with a color index. */
+unsigned int lat2eps_get_color(unsigned int index)
+{
+	return lat2eps_ctx_get_color(default_ctx(), index);
+}
+
+
+/* Selects the EPS lattice encoder. */
+void lat2eps_set_encoder(int mode)
+{
+	lat2eps_ctx_set_encoder(default_ctx(), mode);
+}
+
+
+/* Adds a text entry */
+void lat2eps_text_out(float x, float y, float ax, float ay, float angle, unsigned int size, unsigned int color, const char *text)
+{
+	lat2eps_ctx_text_out(default_ctx(), x, y, ax, ay, angle, size, color, text);
+}
+
+
+/* Generates lattice graphic in EPS. */
+int lat2eps_gen_eps(const char *filename, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height, unsigned int border, unsigned int scale)
+{
+	return lat2eps_ctx_gen_eps(default_ctx(), filename, xoff, yoff, width, height, border, scale);
+}
+
+
+/* Generates a raster image (PPM or PNG) from a caller-owned lattice buffer. */
+int lat2eps_gen_raster(const char *filename, const uint8_t *buffer, unsigned int width, unsigned int height, unsigned int scale, int format)
+{
+	return lat2eps_ctx_gen_raster(default_ctx(), filename, buffer, width, height, scale, format);
+}
+
+
+/* Creates a context with its own lattice and the default palette. */
+lat2eps_ctx *lat2eps_ctx_create(unsigned int width, unsigned int height)
+{
+	lat2eps_ctx *ctx;
+
+	if ((width > LAT2EPS_MAXL) || (height > LAT2EPS_MAXL)) {
+		return NULL;
+	}
+
+	if (!(ctx = (lat2eps_ctx *)malloc(sizeof(lat2eps_ctx)))) {
+		return NULL;
+	}
+
+	init_ctx(ctx);
+	ctx->maxwidth = width;
+	ctx->maxheight = height;
+
+	if (!(ctx->lattice = (int *)calloc((size_t)width * height, sizeof(int)))) {
+		free(ctx);
+		return NULL;
+	}
+
+	return ctx;
+}
+
+
+/* Releases a context and everything it holds. */
+void lat2eps_ctx_free(lat2eps_ctx *ctx)
+{
+	if (ctx) {
+		release_resources(ctx);
+		free(ctx);
+	}
+}
+
+
+/* Sets the lattice site with coordinates x,y to value s. */
+void lat2eps_ctx_set_site(lat2eps_ctx *ctx, unsigned int x, unsigned int y, int s)
+{
+	if (ctx->lattice && (x < ctx->maxwidth) && (y < ctx->maxheight)) {
+		ctx->lattice[y * ctx->maxwidth + x] = s;
+	}
+}
+
+
+/* Copies a full lattice (one byte per site) from a caller-owned buffer. */
+void lat2eps_ctx_set_lattice(lat2eps_ctx *ctx, const uint8_t *buffer)
+{
+	size_t i, n = (size_t)ctx->maxwidth * ctx->maxheight;
+
+	if (ctx->lattice && buffer) {
+		for (i = 0; i < n; ++i) {
+			ctx->lattice[i] = buffer[i];
+		}
+	}
+}
+
+
+/* Gets the value of the lattice site with coordinates x,y. */
+int lat2eps_ctx_get_site(const lat2eps_ctx *ctx, unsigned int x, unsigned int y)
+{
+	if (ctx->lattice && (x < ctx->maxwidth) && (y < ctx->maxheight)) {
+		return ctx->lattice[y * ctx->maxwidth + x];
 	}
 
 	return 0;
@@ -99,48 +241,63 @@ int lat2eps_get_site(unsigned int x, unsigned int y)
 
 
 /* Sets a color index to a palette entry defined in the 0xRRGGBB format */
-void lat2eps_set_color(unsigned int index, unsigned int pal)
+void lat2eps_ctx_set_color(lat2eps_ctx *ctx, unsigned int index, unsigned int pal)
 {
 	if (index < LAT2EPS_MAXQ) {
-		palette[index] = pal;
+		if (ctx->palette[index] != pal) {
+			ctx->palette[index] = pal;
+			ctx->palcached[index] = 0;
+		}
 	}
 }
 
 
 /* Gets the palette definition associated with a color index. */
-unsigned int lat2eps_get_color(unsigned int index)
+unsigned int lat2eps_ctx_get_color(const lat2eps_ctx *ctx, unsigned int index)
 {
 	if (index < LAT2EPS_MAXQ) {
-		return palette[index];
+		return ctx->palette[index];
 	}
 	
 	return 0;
 }
 
 
+/* Selects the EPS lattice encoder. */
+void lat2eps_ctx_set_encoder(lat2eps_ctx *ctx, int mode)
+{
+	if ((mode == LAT2EPS_RLE) || (mode == LAT2EPS_RECT)) {
+		ctx->encoder = mode;
+	}
+}
+
+
 /* Adds a text entry */
-void lat2eps_text_out(float x, float y, float ax, float ay, float angle, unsigned int size, unsigned int color, const char *text)
+void lat2eps_ctx_text_out(lat2eps_ctx *ctx, float x, float y, float ax, float ay, float angle, unsigned int size, unsigned int color, const char *text)
 {
-	if ((txtcounter < LAT2EPS_MAXT) && (size > 0) && (color < LAT2EPS_MAXQ) && text && (strlen(text) > 0)) {
-		textentry[txtcounter].x = x;
-		textentry[txtcounter].y = y;
-		textentry[txtcounter].ax = ax;
-		textentry[txtcounter].ay = ay;
-		textentry[txtcounter].angle = angle;
-		textentry[txtcounter].size = size;
-		textentry[txtcounter].color = color;
-		textentry[txtcounter].text = strdup(text);
-		txtcounter++;
+	if ((ctx->txtcounter < LAT2EPS_MAXT) && (size > 0) && (color < LAT2EPS_MAXQ) && text && (strlen(text) > 0)) {
+		struct lat2eps_text *t = &ctx->textentry[ctx->txtcounter];
+		t->x = x;
+		t->y = y;
+		t->ax = ax;
+		t->ay = ay;
+		t->angle = angle;
+		t->size = size;
+		t->color = color;
+		t->text = strdup(text);
+		ctx->txtcounter++;
 	}
 }
 
 
 /* Generates lattice graphic in EPS. */
-int lat2eps_gen_eps(const char *filename, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height, unsigned int border, unsigned int scale)
+int lat2eps_ctx_gen_eps(lat2eps_ctx *ctx, const char *filename, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height, unsigned int border, unsigned int scale)
 {
 	FILE *f;
+	unsigned int x, y, i;
+	unsigned char used[LAT2EPS_MAXQ];
 
-	if ((width == 0) || (xoff + width > maxwidth) || (height == 0) || (yoff + height > maxheight) || (scale == 0)) {
+	if (!ctx->lattice || (width == 0) || (xoff + width > ctx->maxwidth) || (height == 0) || (yoff + height > ctx->maxheight) || (scale == 0)) {
 		return 0;
 	}
 
@@ -152,9 +309,24 @@ int lat2eps_gen_eps(const char *filename, unsigned int xoff, unsigned int yoff,
 		f = stdout;
 	}
 
-	gen_eps_prolog(f, width, height, scale, border);
-	gen_eps_lattice(f, xoff, yoff, width, height);
-	gen_eps_epilog(f, width, height, scale, border);
+	if (ctx->encoder == LAT2EPS_RECT) {
+		/* Only the colors in use (lattice and text) go to the palette of the prolog. */
+		memset(used, 0, sizeof(used));
+		for (y = 0; y < height; ++y) {
+			for (x = 0; x < width; ++x) {
+				used[(unsigned int)ctx->lattice[(yoff + y) * ctx->maxwidth + xoff + x] % LAT2EPS_MAXQ] = 1;
+			}
+		}
+		for (i = 0; i < ctx->txtcounter; ++i) {
+			used[ctx->textentry[i].color] = 1;
+		}
+	}
+
+	gen_eps_prolog(ctx, f, width, height, scale, border, (ctx->encoder == LAT2EPS_RECT) ? used : NULL);
+	if ((ctx->encoder == LAT2EPS_RLE) || !gen_eps_rects(ctx, f, xoff, yoff, width, height)) {
+		gen_eps_lattice(ctx, f, xoff, yoff, width, height);
+	}
+	gen_eps_epilog(ctx, f, width, height, scale, border);
 
 	if (filename) {
 		fclose(f);
@@ -164,24 +336,98 @@ int lat2eps_gen_eps(const char *filename, unsigned int xoff, unsigned int yoff,
 }
 
 
-static void release_resources()
+/* Generates a raster image (PPM or PNG) from a caller-owned lattice buffer, with the palette of the context. */
+int lat2eps_ctx_gen_raster(const lat2eps_ctx *ctx, const char *filename, const uint8_t *buffer, unsigned int width, unsigned int height, unsigned int scale, int format)
+{
+	FILE *f;
+	int ret;
+
+	if (!buffer || (width == 0) || (width > LAT2EPS_MAXL) || (height == 0) || (height > LAT2EPS_MAXL) || (scale == 0)) {
+		return 0;
+	}
+
+	if ((format != LAT2EPS_PPM) && (format != LAT2EPS_PNG)) {
+		return 0;
+	}
+
+	if (filename) {
+		if (!(f = fopen(filename, "wb"))) {
+			return 0;
+		}
+	} else {
+		f = stdout;
+	}
+
+	if (format == LAT2EPS_PPM)
+		ret = gen_ppm(ctx, f, buffer, width, height, scale);
+	else
+		ret = gen_png(ctx, f, buffer, width, height, scale);
+
+	if (filename) {
+		if (fclose(f) != 0) {
+			ret = 0;
+		}
+	}
+
+	return ret;
+}
+
+
+/* Context of the original functions. Its palette is set up on first use, so that lat2eps_set_color() and lat2eps_gen_raster() also work before lat2eps_init(). */
+static lat2eps_ctx *default_ctx()
+{
+	if (!definit) {
+		init_ctx(&defctx);
+		definit = 1;
+	}
+
+	return &defctx;
+}
+
+
+/* Empty context with the default palette and encoder. */
+static void init_ctx(lat2eps_ctx *ctx)
+{
+	ctx->lattice = NULL;
+	ctx->maxwidth = 0;
+	ctx->maxheight = 0;
+	ctx->encoder = LAT2EPS_RECT;
+	ctx->txtcounter = 0;
+	memset(ctx->palette, 0, sizeof(ctx->palette));
+	memset(ctx->palcached, 0, sizeof(ctx->palcached));
+	init_palette(ctx);
+}
+
+
+/* Initializes the palette table by repeating the colors from the default palette table. Cached definitions of unchanged colors are kept. */
+static void init_palette(lat2eps_ctx *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < LAT2EPS_MAXQ; ++i) {
+		lat2eps_ctx_set_color(ctx, i, defpalette[i % (sizeof(defpalette) / sizeof(defpalette[0]))]);
+	}
+}
+
+
+static void release_resources(lat2eps_ctx *ctx)
 {
 	unsigned int i;
 
-	free(lattice);
-	lattice = NULL;
-	maxwidth = 0;
-	maxheight = 0;
+	free(ctx->lattice);
+	ctx->lattice = NULL;
+	ctx->maxwidth = 0;
+	ctx->maxheight = 0;
 
-	for (i = 0; i < txtcounter; ++i) {
-		free(textentry[i].text);
+	for (i = 0; i < ctx->txtcounter; ++i) {
+		free(ctx->textentry[i].text);
 	}
-	txtcounter = 0;
+	ctx->txtcounter = 0;
 }
 
 
-/* Generates EPS prolog, including Line/Pixel/Text procedures and palette definition. */
-static void gen_eps_prolog(FILE *f, unsigned int width, unsigned int height, unsigned int scale, unsigned int border)
+/* Generates EPS prolog, including Line/Pixel/Rectangle/Text procedures and palette definition (only the entries flagged in used, if given). */
+static void gen_eps_prolog(lat2eps_ctx *ctx, FILE *f, unsigned int width, unsigned int height, unsigned int scale, unsigned int border, const unsigned char *used)
 {
 	unsigned int i;
 
@@ -195,6 +441,8 @@ static void gen_eps_prolog(FILE *f, unsigned int width, unsigned int height, uns
 	fprintf(f, "/L { 2 rectfill } def\n");
 	/* Pixel procedure. */
 	fprintf(f, "/P { 1 2 rectfill } def\n");
+	/* Rectangle procedure (x y w h), with the same extra row of overlap. */
+	fprintf(f, "/R { 1 add rectfill } def\n");
 
 	/* Text procedure */
 	fprintf(f, "/T { /SS exch def /SZ exch def /RR exch def /AY exch def /AX exch def /YY exch def /XX exch def\n");
@@ -202,9 +450,15 @@ static void gen_eps_prolog(FILE *f, unsigned int width, unsigned int height, uns
 	fprintf(f, "/WW exch def /HH exch def XX WW RR cos mul AX mul sub HH RR sin mul 1 AY sub mul add\n");
 	fprintf(f, "YY neg WW RR sin mul AX mul sub HH RR cos mul 1 AY sub mul sub newpath moveto RR rotate SS show grestore } def\n");
 
-	/* Palette */
+	/* Palette. The definitions are formatted once per context, and again only for the colors changed since. */
 	for (i = 0; i < LAT2EPS_MAXQ; ++i) {
-		fprintf(f, "/C%X { %f %f %f setrgbcolor } def\n", i, ((palette[i] >> 16) & 255)/255.0, ((palette[i] >> 8) & 255)/255.0, (palette[i] & 255)/255.0);
+		if (used && !used[i]) continue;
+		if (!ctx->palcached[i]) {
+			unsigned int pal = ctx->palette[i];
+			snprintf(ctx->palps[i], sizeof(ctx->palps[i]), "/C%X { %f %f %f setrgbcolor } def\n", i, ((pal >> 16) & 255)/255.0, ((pal >> 8) & 255)/255.0, (pal & 255)/255.0);
+			ctx->palcached[i] = 1;
+		}
+		fputs(ctx->palps[i], f);
 	}
 
 	fprintf(f, "%%%%EndProlog\n");
@@ -215,13 +469,14 @@ static void gen_eps_prolog(FILE *f, unsigned int width, unsigned int height, uns
 
 
 /* Generates EPS epilog. */
-static void gen_eps_epilog(FILE *f, unsigned int width, unsigned int height, unsigned int scale, unsigned int border)
+static void gen_eps_epilog(const lat2eps_ctx *ctx, FILE *f, unsigned int width, unsigned int height, unsigned int scale, unsigned int border)
 {
 	unsigned int i;
 
 	/* Outputs text entries */
-	for (i = 0; i < txtcounter; ++i) {
-		fprintf(f, "C%X %f %f %f %f %f %u (%s) T\n", textentry[i].color, textentry[i].x, textentry[i].y, textentry[i].ax, textentry[i].ay, textentry[i].angle, textentry[i].size, textentry[i].text);
+	for (i = 0; i < ctx->txtcounter; ++i) {
+		const struct lat2eps_text *t = &ctx->textentry[i];
+		fprintf(f, "C%X %f %f %f %f %f %u (%s) T\n", t->color, t->x, t->y, t->ax, t->ay, t->angle, t->size, t->text);
 	}
 
 	/* Outputs border */
@@ -234,7 +489,7 @@ static void gen_eps_epilog(FILE *f, unsigned int width, unsigned int height, uns
 
 
 /* Generates lattice graphic in EPS. Each lattice line is run-length encoded, generating a single "line" call for a sequence of adjacent sites of the same type. */
-static void gen_eps_lattice(FILE *f, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height)
+static void gen_eps_lattice(const lat2eps_ctx *ctx, FILE *f, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height)
 {
 	unsigned int x, y, col;
 
@@ -242,11 +497,11 @@ static void gen_eps_lattice(FILE *f, unsigned int xoff, unsigned int yoff, unsig
 
 		for (x = 0; x < width;) {
 
-			int s = lattice[(yoff + y) * maxwidth + xoff + x];
+			int s = ctx->lattice[(yoff + y) * ctx->maxwidth + xoff + x];
 			unsigned int cnt = 1;
 
 			/* Counts the length of a sequence of sites of the same type. */
-			while ((x + cnt < width) && (lattice[(yoff + y) * maxwidth + xoff + x + cnt] == s)) ++cnt;
+			while ((x + cnt < width) && (ctx->lattice[(yoff + y) * ctx->maxwidth + xoff + x + cnt] == s)) ++cnt;
 			
 			/* Maps any positive or negative site value to one of the available colors. */
 			col = (unsigned int)s % LAT2EPS_MAXQ;
@@ -261,3 +516,422 @@ static void gen_eps_lattice(FILE *f, unsigned int xoff, unsigned int yoff, unsig
 	}
 }
 
+
+/* Generates lattice graphic in EPS with rectangles. The most frequent color is painted first as a single background rectangle, and only the
+   other sites are drawn over it. Every such site either extends a rectangle that is open since a previous row (when the whole width of that
+   rectangle still has its color) or starts a new one with the run-length of the remaining sites of its color. Rectangles are written in the
+   order of their last row, so that the extra row of overlap of each one is painted over by the rows below it; background sites under that
+   overlap are drawn again for this reason.
+   Return: zero if the work buffers could not be allocated. */
+static int gen_eps_rects(const lat2eps_ctx *ctx, FILE *f, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height)
+{
+	unsigned int x, y, k, col, bg, last;
+	unsigned int *ow, *oy, *oc, *hist;
+	unsigned char *need;
+
+	ow = (unsigned int *)calloc(width, sizeof(unsigned int));   /* width of the rectangle open at column x (0 for none) */
+	oy = (unsigned int *)malloc(width * sizeof(unsigned int));  /* its first row */
+	oc = (unsigned int *)malloc(width * sizeof(unsigned int));  /* its color */
+	hist = (unsigned int *)calloc(LAT2EPS_MAXQ, sizeof(unsigned int));
+	need = (unsigned char *)malloc(width);                      /* 0: covered/background, 1: to be drawn, 2: background under an overlap */
+
+	if (!ow || !oy || !oc || !hist || !need) {
+		free(ow);
+		free(oy);
+		free(oc);
+		free(hist);
+		free(need);
+		return 0;
+	}
+
+	/* Background color */
+	for (y = 0; y < height; ++y) {
+		for (x = 0; x < width; ++x) {
+			hist[(unsigned int)ctx->lattice[(yoff + y) * ctx->maxwidth + xoff + x] % LAT2EPS_MAXQ]++;
+		}
+	}
+	for (bg = 0, col = 1; col < LAT2EPS_MAXQ; ++col) {
+		if (hist[col] > hist[bg]) bg = col;
+	}
+	fprintf(f, "C%X 0 0 %u %u R\n", bg, width, height);
+	last = bg;
+
+	memset(need, 0, width);
+
+	for (y = 0; y <= height; ++y) {
+
+		const int *row = (y < height) ? &ctx->lattice[(yoff + y) * ctx->maxwidth + xoff] : NULL;
+
+		/* Sites of this row still to be drawn (need[] already holds the overlaps of the rectangles closed at the previous row). */
+		for (x = 0; row && (x < width); ++x) {
+			if ((unsigned int)row[x] % LAT2EPS_MAXQ != bg) need[x] = 1;
+		}
+
+		/* Extends or closes the open rectangles. */
+		for (x = 0; x < width; ++x) {
+
+			if (ow[x] == 0) continue;
+
+			for (k = 0; row && (k < ow[x]) && ((unsigned int)row[x + k] % LAT2EPS_MAXQ == oc[x]); ++k);
+
+			if (row && (k == ow[x])) {
+				memset(need + x, 0, ow[x]);
+			} else {
+				unsigned int h = y - oy[x];
+
+				if (oc[x] != last) {
+					fprintf(f, "C%X ", oc[x]);
+					last = oc[x];
+				}
+				if (h > 1)
+					fprintf(f, "%u %u %u %u R\n", x, oy[x], ow[x], h);
+				else if (ow[x] > 1)
+					fprintf(f, "%u %u %u L\n", x, oy[x], ow[x]);
+				else
+					fprintf(f, "%u %u P\n", x, oy[x]);
+
+				/* Its overlap row must be painted again where this row is background. */
+				if (row && (oc[x] != bg)) {
+					for (k = 0; k < ow[x]; ++k) {
+						if ((need[x + k] == 0) && ((unsigned int)row[x + k] % LAT2EPS_MAXQ == bg)) need[x + k] = 2;
+					}
+				}
+
+				ow[x] = 0;
+			}
+		}
+
+		if (!row) break;
+
+		/* Opens rectangles over the runs of sites still to be drawn. */
+		for (x = 0; x < width;) {
+
+			unsigned int cnt = 1;
+
+			if (!need[x]) {
+				++x;
+				continue;
+			}
+
+			col = (unsigned int)row[x] % LAT2EPS_MAXQ;
+			while ((x + cnt < width) && need[x + cnt] && ((unsigned int)row[x + cnt] % LAT2EPS_MAXQ == col)) ++cnt;
+
+			ow[x] = cnt;
+			oy[x] = y;
+			oc[x] = col;
+
+			x += cnt;
+		}
+
+		memset(need, 0, width);
+	}
+
+	free(ow);
+	free(oy);
+	free(oc);
+	free(hist);
+	free(need);
+
+	return 1;
+}
+
+
+/* Generates a binary PPM (P6). Each output row is built once and written scale times. */
+static int gen_ppm(const lat2eps_ctx *ctx, FILE *f, const uint8_t *buffer, unsigned int width, unsigned int height, unsigned int scale)
+{
+	size_t rowlen = (size_t)width * scale * 3;
+	uint8_t *row = (uint8_t *)malloc(rowlen);
+	unsigned int x, y, i;
+
+	if (!row) {
+		return 0;
+	}
+
+	fprintf(f, "P6\n%u %u\n255\n", width * scale, height * scale);
+
+	for (y = 0; y < height; ++y) {
+
+		uint8_t *p = row;
+
+		for (x = 0; x < width; ++x) {
+			unsigned int pal = ctx->palette[buffer[(size_t)y * width + x]];
+			for (i = 0; i < scale; ++i) {
+				*p++ = (pal >> 16) & 255;
+				*p++ = (pal >> 8) & 255;
+				*p++ = pal & 255;
+			}
+		}
+
+		for (i = 0; i < scale; ++i) {
+			if (fwrite(row, 1, rowlen, f) != rowlen) {
+				free(row);
+				return 0;
+			}
+		}
+	}
+
+	free(row);
+	return 1;
+}
+
+
+/* Big-endian 32 bits. */
+static void put_u32(uint8_t *p, uint32_t v)
+{
+	p[0] = (v >> 24) & 255;
+	p[1] = (v >> 16) & 255;
+	p[2] = (v >> 8) & 255;
+	p[3] = v & 255;
+}
+
+
+/* Table of the CRC-32 used by the PNG chunks (built per image, so that no state is shared between threads). */
+static void png_crc_table(uint32_t *table)
+{
+	uint32_t c, n, k;
+
+	for (n = 0; n < 256; ++n) {
+		c = n;
+		for (k = 0; k < 8; ++k) {
+			c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		}
+		table[n] = c;
+	}
+}
+
+
+/* CRC-32 used by the PNG chunks. */
+static uint32_t png_crc(const uint32_t *table, uint32_t crc, const uint8_t *buf, size_t len)
+{
+	size_t i;
+
+	crc = ~crc;
+	for (i = 0; i < len; ++i) {
+		crc = table[(crc ^ buf[i]) & 255] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+
+/* Writes a PNG chunk (length, type, data, crc). */
+static int png_chunk(FILE *f, const uint32_t *table, const char *type, const uint8_t *data, size_t len)
+{
+	uint8_t hdr[8], tail[4];
+	uint32_t crc;
+
+	put_u32(hdr, (uint32_t)len);
+	memcpy(hdr + 4, type, 4);
+	crc = png_crc(table, 0, hdr + 4, 4);
+	crc = png_crc(table, crc, data, len);
+	put_u32(tail, crc);
+
+	return (fwrite(hdr, 1, 8, f) == 8) && ((len == 0) || (fwrite(data, 1, len, f) == len)) && (fwrite(tail, 1, 4, f) == 4);
+}
+
+
+/* Generates an 8-bit indexed PNG. Scanlines use no filter; the upscaled rows and runs are left to the LZ77 matcher. */
+static int gen_png(const lat2eps_ctx *ctx, FILE *f, const uint8_t *buffer, unsigned int width, unsigned int height, unsigned int scale)
+{
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	size_t w = (size_t)width * scale, h = (size_t)height * scale;
+	size_t rawlen = (w + 1) * h, zlen, pos = 0;
+	uint8_t ihdr[13], plte[LAT2EPS_MAXQ * 3];
+	uint32_t crctable[256];
+	uint8_t *raw, *z;
+	uint32_t a = 1, b = 0;
+	unsigned int x, y, i;
+	int ok;
+
+	raw = (uint8_t *)malloc(rawlen);
+	z = (uint8_t *)malloc(rawlen + rawlen / 8 + 64);
+	if (!raw || !z) {
+		free(raw);
+		free(z);
+		return 0;
+	}
+
+	/* Filtered (filter type 0) image data. */
+	for (y = 0; y < height; ++y) {
+		for (i = 0; i < scale; ++i) {
+			raw[pos++] = 0;
+			for (x = 0; x < width; ++x) {
+				memset(raw + pos, buffer[(size_t)y * width + x], scale);
+				pos += scale;
+			}
+		}
+	}
+
+	/* zlib stream: header, deflate data, adler32. */
+	z[0] = 0x78;
+	z[1] = 0x01;
+	zlen = deflate_fixed(raw, rawlen, z + 2);
+	if (zlen == 0) {
+		free(raw);
+		free(z);
+		return 0;
+	}
+	zlen += 2;
+	for (pos = 0; pos < rawlen; ++pos) {
+		a = (a + raw[pos]) % 65521;
+		b = (b + a) % 65521;
+	}
+	put_u32(z + zlen, (b << 16) | a);
+	zlen += 4;
+
+	put_u32(ihdr, (uint32_t)w);
+	put_u32(ihdr + 4, (uint32_t)h);
+	ihdr[8] = 8;    /* bit depth */
+	ihdr[9] = 3;    /* indexed color */
+	ihdr[10] = 0;   /* deflate */
+	ihdr[11] = 0;   /* adaptive filtering */
+	ihdr[12] = 0;   /* no interlace */
+
+	for (i = 0; i < LAT2EPS_MAXQ; ++i) {
+		plte[3 * i] = (ctx->palette[i] >> 16) & 255;
+		plte[3 * i + 1] = (ctx->palette[i] >> 8) & 255;
+		plte[3 * i + 2] = ctx->palette[i] & 255;
+	}
+
+	png_crc_table(crctable);
+
+	ok = (fwrite(signature, 1, 8, f) == 8);
+	ok = ok && png_chunk(f, crctable, "IHDR", ihdr, sizeof(ihdr));
+	ok = ok && png_chunk(f, crctable, "PLTE", plte, sizeof(plte));
+	ok = ok && png_chunk(f, crctable, "IDAT", z, zlen);
+	ok = ok && png_chunk(f, crctable, "IEND", NULL, 0);
+
+	free(raw);
+	free(z);
+	return ok;
+}
+
+
+/* Appends n bits (LSB first) to the deflate stream. */
+static void put_bits(bitwriter *bw, uint32_t bits, unsigned int n)
+{
+	bw->bitbuf |= bits << bw->bitcnt;
+	bw->bitcnt += n;
+	while (bw->bitcnt >= 8) {
+		bw->out[bw->pos++] = bw->bitbuf & 255;
+		bw->bitbuf >>= 8;
+		bw->bitcnt -= 8;
+	}
+}
+
+
+/* Appends a Huffman code, which deflate stores MSB first. */
+static void put_code(bitwriter *bw, uint32_t code, unsigned int n)
+{
+	uint32_t rev = 0;
+	unsigned int i;
+
+	for (i = 0; i < n; ++i) {
+		rev = (rev << 1) | ((code >> i) & 1);
+	}
+	put_bits(bw, rev, n);
+}
+
+
+/* Fixed Huffman code of a literal/length symbol. */
+static void put_litlen(bitwriter *bw, unsigned int sym)
+{
+	if (sym < 144)
+		put_code(bw, 0x30 + sym, 8);
+	else if (sym < 256)
+		put_code(bw, 0x190 + sym - 144, 9);
+	else if (sym < 280)
+		put_code(bw, sym - 256, 7);
+	else
+		put_code(bw, 0xC0 + sym - 280, 8);
+}
+
+
+/* Emits a <length, distance> pair with the fixed codes. */
+static void put_match(bitwriter *bw, unsigned int len, unsigned int dist)
+{
+	static const unsigned short lbase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const unsigned char lextra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const unsigned short dbase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const unsigned char dextra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	unsigned int l = 28, d = 29;
+
+	while (lbase[l] > len) --l;
+	while (dbase[d] > dist) --d;
+
+	put_litlen(bw, 257 + l);
+	put_bits(bw, len - lbase[l], lextra[l]);
+	put_code(bw, d, 5);
+	put_bits(bw, dist - dbase[d], dextra[d]);
+}
+
+
+/* Deflate (RFC 1951) with a single fixed-Huffman block and greedy LZ77 matching over hash chains. Returns the compressed size (zero if the work buffers could not be allocated). */
+static size_t deflate_fixed(const uint8_t *in, size_t n, uint8_t *out)
+{
+	bitwriter bw = { out, 0, 0, 0 };
+	int32_t *head = (int32_t *)malloc(sizeof(int32_t) << DEFL_HBITS);
+	int32_t *prev = (int32_t *)malloc(sizeof(int32_t) * DEFL_WSIZE);
+	size_t i = 0, j;
+
+	if (!head || !prev) {
+		free(head);
+		free(prev);
+		return 0;
+	}
+
+	for (j = 0; j < ((size_t)1 << DEFL_HBITS); ++j) {
+		head[j] = -1;
+	}
+
+	put_bits(&bw, 1, 1);   /* BFINAL */
+	put_bits(&bw, 1, 2);   /* BTYPE = fixed Huffman */
+
+	while (i < n) {
+
+		unsigned int bestlen = 0, bestdist = 0;
+
+		if (i + 3 <= n) {
+
+			uint32_t h = ((in[i] << 10) ^ (in[i + 1] << 5) ^ in[i + 2]) & ((1u << DEFL_HBITS) - 1);
+			int32_t cand = head[h];
+			unsigned int chain = DEFL_CHAIN;
+			size_t maxlen = (n - i < DEFL_MAXLEN) ? n - i : DEFL_MAXLEN;
+
+			while ((cand >= 0) && (i - (size_t)cand <= DEFL_WSIZE - 1) && chain--) {
+				unsigned int len = 0;
+				while ((len < maxlen) && (in[cand + len] == in[i + len])) ++len;
+				if (len > bestlen) {
+					bestlen = len;
+					bestdist = (unsigned int)(i - cand);
+					if (len == maxlen) break;
+				}
+				cand = prev[cand % DEFL_WSIZE];
+			}
+		}
+
+		if (bestlen >= 3) {
+			put_match(&bw, bestlen, bestdist);
+		} else {
+			bestlen = 1;
+			put_litlen(&bw, in[i]);
+		}
+
+		/* Inserts every position covered by the literal/match in the hash chains. */
+		for (j = 0; j < bestlen; ++j, ++i) {
+			if (i + 3 <= n) {
+				uint32_t h = ((in[i] << 10) ^ (in[i + 1] << 5) ^ in[i + 2]) & ((1u << DEFL_HBITS) - 1);
+				prev[i % DEFL_WSIZE] = head[h];
+				head[h] = (int32_t)i;
+			}
+		}
+	}
+
+	put_litlen(&bw, 256);   /* end of block */
+	if (bw.bitcnt > 0) {
+		put_bits(&bw, 0, 8 - bw.bitcnt);
+	}
+
+	free(head);
+	free(prev);
+	return bw.pos;
+}
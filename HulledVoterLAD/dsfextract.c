@@ -0,0 +1,131 @@
+/*************************************************************************
+*                Indexed extraction of one measurement time              *
+*                             V1.0 19/10/2026                            *
+*************************************************************************/
+
+/***************************************************************
+ *                            USAGE
+ **************************************************************/
+// gcc -O3 dsfextract.c -o dsfextract
+// ./dsfextract TIME files_3.dsf ...      > dj1
+// ./dsfextract -b files_3.dsf ...        [build missing .idx of old outputs]
+//
+// Same output as
+//   printf '%s ' *_3.dsf | xargs cat | awk -f distribution.awk -v TIME=...
+// but each file costs one seek and one read through the .idx sidecar.
+// Files without sidecar are scanned once (and indexed with -b).
+
+/***************************************************************
+ *                            INCLUDES
+ **************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "dsfindex.h"
+
+/***************************************************************
+ *                            FUNCTIONS
+ **************************************************************/
+
+void header(const char *, int);
+void printblock(const char *);
+
+/***************************************************************
+ *                         GLOBAL VARIABLES
+ **************************************************************/
+
+int printL=0;
+int samples=0;
+
+/***************************************************************
+ *                          MAIN PROGRAM
+ **************************************************************/
+int main(int argc, char *argv[]){
+
+  if(argc<3){
+    fprintf(stderr,"Usage: %s TIME files.dsf ...\n",argv[0]);
+    fprintf(stderr,"       %s -b files.dsf ...\n",argv[0]);
+    return 1;
+  }
+
+  if(strcmp(argv[1],"-b")==0){
+    for(int i=2; i<argc; i++){
+      int n = dsf_index_build(argv[i]);
+      if(n<0)fprintf(stderr,"%s: can not be read\n",argv[i]);
+    }
+    return 0;
+  }
+
+  int tempo = atoi(argv[1]);
+  int files = 0;
+  for(int i=2; i<argc; i++){
+    header(argv[i],tempo);
+    files++;
+    char *block = dsf_read_block(argv[i],tempo);
+    if(block==NULL){
+      dsfblock *blocks;
+      if(dsf_index_load(argv[i],&blocks)>=0){
+        free(blocks);
+        continue; //run reached consensus before TIME
+      }
+      if(dsf_index_build(argv[i])<0)continue;
+      block = dsf_read_block(argv[i],tempo);
+      if(block==NULL)continue;
+    }
+    printblock(block);
+    free(block);
+  }
+  printf("# Files processed: %d  Samples: %d\n",files,samples);
+
+  return 0;
+}
+
+/**************************************************************
+ *       File header (domain type and linear size)
+ *************************************************************/
+void header(const char *fname, int _tempo){
+  char line[1024],domain[64];
+  FILE *fp;
+
+  if(printL==1)return;
+  fp = fopen(fname,"r");
+  if(fp==NULL)return;
+  domain[0]='\0';
+  while(fgets(line,sizeof line,fp)!=NULL){
+    if(line[0]!='#')break;
+    if(strncmp(line,"# LAD",5)==0)sscanf(line,"%*s %*s %*s %*s %*s %63s",domain);
+    if(strncmp(line,"# Linear",8)==0){
+      printf("# Domain: %s\n",domain);
+      printf("%s",line);
+      printf("# Time: %d\n",_tempo);
+      printL=1;
+      break;
+    }
+  }
+  fclose(fp);
+}
+
+/**************************************************************
+ *       Data lines of a block (comments and blanks skipped)
+ *************************************************************/
+void printblock(const char *block){
+  bool first=true;
+  const char *p = block;
+
+  while(*p!='\0'){
+    const char *end = strchr(p,'\n');
+    int len = (end==NULL) ? (int)strlen(p) : (int)(end-p);
+    if(len>0 && p[0]!='#'){
+      if(first){
+        samples++;
+        printf("# Sample = %d\n",samples);
+        first=false;
+      }
+      printf("%.*s\n",len,p);
+    }
+    if(end==NULL)break;
+    p = end+1;
+  }
+}
@@ -0,0 +1,185 @@
+/********************************************************************
+***                   Time-block Index for .dsf files              ***
+***                     Last Modified: 19/10/2026                  ***
+***                                                                ***
+***  The auxiliary outputs (_2, _3 and _4.dsf) are a sequence of   ***
+***  blocks, one per measurement, each starting with "# Time:".    ***
+***  For every block the writer appends one line to a sidecar      ***
+***  file (name.dsf.idx) with the time, the byte offset of the     ***
+***  block and its length:                                         ***
+***                                                                ***
+***                  # Time Offset Length                          ***
+***                  1000 52311 1873                               ***
+***                                                                ***
+***  so a reader only needs a seek and a single read to get the    ***
+***  block of a given time, without scanning the whole file.       ***
+********************************************************************/
+
+#ifndef DSFINDEX_H
+#define DSFINDEX_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DSFINDEX_EXT  ".idx"
+
+typedef struct {
+  int tempo;
+  long offset;
+  long length;
+} dsfblock;
+
+/********************************************************************
+*                         Writer side                               *
+*                                                                   *
+*  dsf_index_open: creates the sidecar of the .dsf file "dsfname"   *
+*  dsf_index_add: records the block of time "tempo" that starts at  *
+*                 "offset" and ends at the current position of fp   *
+********************************************************************/
+FILE *dsf_index_open(const char *dsfname)
+{
+  char name[400];
+  FILE *idx;
+
+  snprintf(name,sizeof name,"%s%s",dsfname,DSFINDEX_EXT);
+  idx = fopen(name,"w");
+  if (idx == NULL) return NULL;
+  fprintf(idx,"# Time Offset Length\n");
+  fflush(idx);
+  return idx;
+}
+
+void dsf_index_add(FILE *idx, FILE *fp, int tempo, long offset)
+{
+  if (idx == NULL) return;
+  fprintf(idx,"%d %ld %ld\n",tempo,offset,ftell(fp)-offset);
+  fflush(idx);
+}
+
+/********************************************************************
+*                    Index build (old files)                        *
+*                                                                   *
+*  Scans a .dsf file once and writes its sidecar. Used for outputs  *
+*  generated before the index existed.                              *
+*  Return: number of blocks, -1 if the file can not be read.        *
+********************************************************************/
+int dsf_index_build(const char *dsfname)
+{
+  char line[1024];
+  FILE *fp,*idx;
+  long pos,start=-1;
+  int tempo=0,nblocks=0;
+
+  fp = fopen(dsfname,"r");
+  if (fp == NULL) return -1;
+  idx = dsf_index_open(dsfname);
+  if (idx == NULL) {
+    fclose(fp);
+    return -1;
+  }
+
+  pos = ftell(fp);
+  while (fgets(line,sizeof line,fp) != NULL) {
+    if (strncmp(line,"# Time:",7) == 0) {
+      if (start >= 0) {
+        fprintf(idx,"%d %ld %ld\n",tempo,start,pos-start);
+        nblocks++;
+      }
+      tempo = atoi(line+7);
+      start = pos;
+    }
+    pos = ftell(fp);
+  }
+  if (start >= 0) {
+    fprintf(idx,"%d %ld %ld\n",tempo,start,pos-start);
+    nblocks++;
+  }
+
+  fclose(idx);
+  fclose(fp);
+  return nblocks;
+}
+
+/********************************************************************
+*                         Reader side                               *
+*                                                                   *
+*  dsf_index_load: reads the sidecar of "dsfname" into *blocks      *
+*                  (allocated here, freed by the caller).           *
+*                  Return: number of blocks, -1 if there is no idx. *
+*  dsf_index_find: position of time "tempo" in blocks, -1 if the    *
+*                  run did not reach it.                            *
+*  dsf_read_block: seeks and reads the block of time "tempo".       *
+*                  Return: NUL terminated buffer (freed by the      *
+*                  caller) or NULL.                                 *
+********************************************************************/
+int dsf_index_load(const char *dsfname, dsfblock **blocks)
+{
+  char name[400],line[256];
+  FILE *idx;
+  int n=0,size=64;
+  dsfblock b;
+
+  snprintf(name,sizeof name,"%s%s",dsfname,DSFINDEX_EXT);
+  idx = fopen(name,"r");
+  if (idx == NULL) return -1;
+
+  *blocks = malloc(size*sizeof(dsfblock));
+  while (fgets(line,sizeof line,idx) != NULL) {
+    if (line[0] == '#') continue;
+    if (sscanf(line,"%d %ld %ld",&b.tempo,&b.offset,&b.length) != 3) continue;
+    if (n == size) {
+      size *= 2;
+      *blocks = realloc(*blocks,size*sizeof(dsfblock));
+    }
+    (*blocks)[n++] = b;
+  }
+  fclose(idx);
+  return n;
+}
+
+int dsf_index_find(const dsfblock *blocks, int nblocks, int tempo)
+{
+  int lo=0,hi=nblocks-1;
+
+  /* measurement times are written in increasing order */
+  while (lo <= hi) {
+    int mid = (lo+hi)/2;
+    if (blocks[mid].tempo == tempo) return mid;
+    if (blocks[mid].tempo < tempo) lo = mid+1;
+    else hi = mid-1;
+  }
+  return -1;
+}
+
+char *dsf_read_block(const char *dsfname, int tempo)
+{
+  dsfblock *blocks;
+  char *buffer;
+  FILE *fp;
+  int n,b;
+
+  n = dsf_index_load(dsfname,&blocks);
+  if (n < 0) return NULL;
+  b = dsf_index_find(blocks,n,tempo);
+  if (b < 0) {
+    free(blocks);
+    return NULL;
+  }
+
+  fp = fopen(dsfname,"r");
+  if (fp == NULL) {
+    free(blocks);
+    return NULL;
+  }
+  buffer = malloc(blocks[b].length+1);
+  fseek(fp,blocks[b].offset,SEEK_SET);
+  blocks[b].length = fread(buffer,1,blocks[b].length,fp);
+  buffer[blocks[b].length] = '\0';
+
+  fclose(fp);
+  free(blocks);
+  return buffer;
+}
+
+#endif
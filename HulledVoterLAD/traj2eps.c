@@ -0,0 +1,127 @@
+/*************************************************************************
+*                  Trajectory (.ltr) frames to lat2eps                   *
+*                             V1.0 19/10/2026                            *
+*************************************************************************/
+
+/***************************************************************
+ *                            USAGE
+ **************************************************************/
+// gcc -O3 traj2eps.c -I liblat2eps/ -L liblat2eps/ -llat2eps -lm -o traj2eps
+// ./traj2eps file.ltr            [list the frames]
+// ./traj2eps file.ltr FRAME      [FRAME -> file[FRAME].eps]
+// ./traj2eps file.ltr -a         [every frame]
+//
+// Frames are rendered with the same palette used by snap():
+// red/blue for zealots, light red/light blue otherwise, black
+// for vacancies.
+
+/***************************************************************
+ *                            INCLUDES
+ **************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lat2eps.h>
+#include "trajectory.h"
+
+/***************************************************************
+ *                            FUNCTIONS
+ **************************************************************/
+
+int render(ladtraj *, long, const char *);
+
+/***************************************************************
+ *                         GLOBAL VARIABLES
+ **************************************************************/
+
+int *spin, *zealot;
+
+/***************************************************************
+ *                          MAIN PROGRAM
+ **************************************************************/
+int main(int argc, char *argv[]){
+
+  if(argc<2){
+    fprintf(stderr,"Usage: %s file.ltr [FRAME|-a]\n",argv[0]);
+    return 1;
+  }
+
+  ladtraj *t = traj_open(argv[1]);
+  if(t==NULL){
+    fprintf(stderr,"%s: not a trajectory file\n",argv[1]);
+    return 1;
+  }
+
+  char root[300];
+  snprintf(root,sizeof root,"%s",argv[1]);
+  char *ext = strstr(root,".ltr");
+  if(ext!=NULL)*ext='\0';
+
+  if(argc==2){
+    printf("# Width: %u Height: %u Frames: %ld Keyinterval: %u\n",t->width,t->height,t->nframes,t->keyinterval);
+    printf("# Frame Time Key\n");
+    for(long f=0; f<t->nframes; f++){
+      printf("%ld %.8f %d\n",f,t->times[f],(t->types[f]&TRAJ_DELTA)==0);
+    }
+    traj_close(t);
+    return 0;
+  }
+
+  spin = malloc(t->nsites*sizeof(int));
+  zealot = malloc(t->nsites*sizeof(int));
+
+  int status = 0;
+  if(strcmp(argv[2],"-a")==0){
+    for(long f=0; f<t->nframes; f++){
+      if(!render(t,f,root))status=1;
+    }
+  }
+  else{
+    if(!render(t,atol(argv[2]),root))status=1;
+  }
+
+  free(spin);
+  free(zealot);
+  traj_close(t);
+  return status;
+}
+
+/**************************************************************
+ *                       Frame -> EPS
+ *************************************************************/
+int render(ladtraj *t, long f, const char *root){
+  char name[400];
+
+  if(!traj_read_frame(t,f,NULL,spin,zealot,NULL)){
+    fprintf(stderr,"frame %ld: can not be read\n",f);
+    return 0;
+  }
+
+  lat2eps_init(t->width,t->height);
+  lat2eps_set_color(0,0x00000); //black
+  lat2eps_set_color(1,0xFFFFFF); //white
+  lat2eps_set_color(4,0xFF0000); // red
+  lat2eps_set_color(5,0x0000FF); // blue
+  lat2eps_set_color(6,0xFF9090); // gray red
+  lat2eps_set_color(7,0x90C2FF); // gray blue
+
+  for(long l=0; l<t->nsites; l++){
+    int x = l%t->width;
+    int y = l/t->width;
+    if(spin[l]==0)lat2eps_set_site(x,y,0);
+    else if(spin[l]==1){
+      if(zealot[l]==1)lat2eps_set_site(x,y,4);
+      else lat2eps_set_site(x,y,6);
+    }
+    else{
+      if(zealot[l]==1)lat2eps_set_site(x,y,5);
+      else lat2eps_set_site(x,y,7);
+    }
+  }
+
+  snprintf(name,sizeof name,"%s[%ld].eps",root,f);
+  int ok = lat2eps_gen_eps(name,0,0,t->width,t->height,1,3);
+  lat2eps_release();
+  return ok;
+}
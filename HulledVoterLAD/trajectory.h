@@ -0,0 +1,415 @@
+/********************************************************************
+***                   Lattice Trajectory Files (.ltr)              ***
+***                     Last Modified: 19/10/2026                  ***
+***                                                                ***
+***  Stores the evolution of a binary LAD lattice frame by frame:  ***
+***  one bit per site for the opinion (spin>0), one for the zealot ***
+***  flag, optionally one for vacancies (diluted lattices) and     ***
+***  optionally the certainty quantised to 8 bits in [0,cmax].     ***
+***                                                                ***
+***  Every keyinterval frames a keyframe is stored; the frames in  ***
+***  between are the XOR with the previous frame, which is almost  ***
+***  all zeros at late times. Both are compressed with an order-1  ***
+***  adaptive binary range coder (LZMA-like bit models), so a late ***
+***  time frame of L=256 costs a few hundred bytes.                ***
+***                                                                ***
+***  Layout (native endianness):                                   ***
+***    "LADT" version width height flags keyinterval cmax          ***
+***    per frame: time type size payload[size]                     ***
+***  type: bit 0 = delta frame, bit 1 = stored without coding.     ***
+***  There is no trailer, so files of killed runs stay readable.   ***
+********************************************************************/
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#define TRAJ_VERSION      1
+#define TRAJ_CERTAINTY    1   /* flag: quantised certainty stored  */
+#define TRAJ_VACANCY      2   /* flag: spin==0 sites (dilution)    */
+#define TRAJ_DELTA        1
+#define TRAJ_STORED       2
+
+typedef struct {
+  FILE *fp;
+  int writing;
+  uint32_t width, height, flags, keyinterval;
+  double cmax;
+  long nsites, planebytes, rawsize;
+  long nframes;
+  unsigned char *prev, *cur, *work, *code;
+  uint16_t *probs;
+  /* frame table (reader) */
+  long *offsets;
+  double *times;
+  unsigned char *types;
+  long decoded;   /* frame held in prev, -1 if none */
+} ladtraj;
+
+/********************************************************************
+*                     Range coder (order-1 bytes)                   *
+********************************************************************/
+typedef struct {
+  uint64_t low;
+  uint32_t range;
+  uint8_t cache;
+  uint64_t cachesize;
+  unsigned char *buf;
+  long pos, cap;
+  int overflow;
+} trajrc;
+
+static void traj_shiftlow(trajrc *rc)
+{
+  if ((uint32_t)rc->low < 0xFF000000u || (rc->low >> 32) != 0) {
+    uint8_t carry = rc->low >> 32;
+    uint8_t temp = rc->cache;
+    do {
+      if (rc->pos < rc->cap) rc->buf[rc->pos++] = temp + carry;
+      else rc->overflow = 1;
+      temp = 0xFF;
+    } while (--rc->cachesize != 0);
+    rc->cache = (rc->low >> 24) & 0xFF;
+  }
+  rc->cachesize++;
+  rc->low = (rc->low & 0x00FFFFFFu) << 8;
+}
+
+static void traj_encodebit(trajrc *rc, uint16_t *p, int bit)
+{
+  uint32_t bound = (rc->range >> 11) * (*p);
+  if (bit == 0) {
+    rc->range = bound;
+    *p += (2048 - *p) >> 5;
+  }
+  else {
+    rc->low += bound;
+    rc->range -= bound;
+    *p -= *p >> 5;
+  }
+  while (rc->range < (1u << 24)) {
+    rc->range <<= 8;
+    traj_shiftlow(rc);
+  }
+}
+
+static int traj_decodebit(trajrc *rc, uint16_t *p, uint32_t *code)
+{
+  int bit;
+  uint32_t bound = (rc->range >> 11) * (*p);
+  if (*code < bound) {
+    rc->range = bound;
+    *p += (2048 - *p) >> 5;
+    bit = 0;
+  }
+  else {
+    *code -= bound;
+    rc->range -= bound;
+    *p -= *p >> 5;
+    bit = 1;
+  }
+  while (rc->range < (1u << 24)) {
+    rc->range <<= 8;
+    *code = (*code << 8) | (rc->pos < rc->cap ? rc->buf[rc->pos++] : 0);
+  }
+  return bit;
+}
+
+static void traj_resetmodel(uint16_t *probs)
+{
+  for (long i = 0; i < 256*256; i++) probs[i] = 1024;
+}
+
+/* Return: compressed size, or -1 if it does not fit in cap bytes. */
+static long traj_compress(const unsigned char *in, long n, unsigned char *out, long cap, uint16_t *probs)
+{
+  trajrc rc = {0, 0xFFFFFFFFu, 0, 1, out, 0, cap, 0};
+  int ctx = 0;
+
+  traj_resetmodel(probs);
+  for (long i = 0; i < n; i++) {
+    uint16_t *p = probs + 256*ctx;
+    int m = 1;
+    for (int b = 7; b >= 0; b--) {
+      int bit = (in[i] >> b) & 1;
+      traj_encodebit(&rc, p+m, bit);
+      m = (m << 1) | bit;
+    }
+    ctx = in[i];
+    if (rc.overflow) return -1;
+  }
+  for (int i = 0; i < 5; i++) traj_shiftlow(&rc);
+  if (rc.overflow) return -1;
+  return rc.pos;
+}
+
+static void traj_decompress(const unsigned char *in, long size, unsigned char *out, long n, uint16_t *probs)
+{
+  trajrc rc = {0, 0xFFFFFFFFu, 0, 0, (unsigned char *)in, 0, size, 0};
+  uint32_t code = 0;
+  int ctx = 0;
+
+  traj_resetmodel(probs);
+  for (int i = 0; i < 5; i++) code = (code << 8) | (rc.pos < rc.cap ? rc.buf[rc.pos++] : 0);
+  for (long i = 0; i < n; i++) {
+    uint16_t *p = probs + 256*ctx;
+    int m = 1;
+    for (int b = 0; b < 8; b++) m = (m << 1) | traj_decodebit(&rc, p+m, &code);
+    out[i] = m & 0xFF;
+    ctx = out[i];
+  }
+}
+
+/********************************************************************
+*                    Frame packing / unpacking                      *
+********************************************************************/
+static void traj_pack(ladtraj *t, unsigned char *raw, const int *spin, const int *zealot, const double *certainty)
+{
+  unsigned char *up = raw, *zl = raw + t->planebytes;
+  unsigned char *vac = raw + 2*t->planebytes;
+  unsigned char *cq = raw + ((t->flags & TRAJ_VACANCY) ? 3 : 2)*t->planebytes;
+
+  memset(raw, 0, t->rawsize);
+  for (long i = 0; i < t->nsites; i++) {
+    if (spin[i] > 0) up[i>>3] |= 1 << (i&7);
+    if (zealot != NULL && zealot[i] != 0) zl[i>>3] |= 1 << (i&7);
+    if ((t->flags & TRAJ_VACANCY) && spin[i] == 0) vac[i>>3] |= 1 << (i&7);
+    if (t->flags & TRAJ_CERTAINTY) {
+      double c = certainty[i];
+      if (c < 0) c = 0;
+      if (c > t->cmax) c = t->cmax;
+      cq[i] = (unsigned char)lround(255.*c/t->cmax);
+    }
+  }
+}
+
+static void traj_unpack(ladtraj *t, const unsigned char *raw, int *spin, int *zealot, double *certainty)
+{
+  const unsigned char *up = raw, *zl = raw + t->planebytes;
+  const unsigned char *vac = raw + 2*t->planebytes;
+  const unsigned char *cq = raw + ((t->flags & TRAJ_VACANCY) ? 3 : 2)*t->planebytes;
+
+  for (long i = 0; i < t->nsites; i++) {
+    if (spin != NULL) {
+      spin[i] = ((up[i>>3] >> (i&7)) & 1) ? 1 : -1;
+      if ((t->flags & TRAJ_VACANCY) && ((vac[i>>3] >> (i&7)) & 1)) spin[i] = 0;
+    }
+    if (zealot != NULL) zealot[i] = (zl[i>>3] >> (i&7)) & 1;
+    if (certainty != NULL) certainty[i] = (t->flags & TRAJ_CERTAINTY) ? cq[i]*t->cmax/255. : 0;
+  }
+}
+
+static ladtraj *traj_alloc(uint32_t width, uint32_t height, uint32_t flags)
+{
+  ladtraj *t = calloc(1, sizeof(ladtraj));
+
+  t->width = width;
+  t->height = height;
+  t->flags = flags;
+  t->nsites = (long)width*height;
+  t->planebytes = (t->nsites + 7)/8;
+  t->rawsize = ((flags & TRAJ_VACANCY) ? 3 : 2)*t->planebytes;
+  if (flags & TRAJ_CERTAINTY) t->rawsize += t->nsites;
+  t->prev = calloc(t->rawsize, 1);
+  t->cur = malloc(t->rawsize);
+  t->work = malloc(t->rawsize);
+  t->code = malloc(t->rawsize + 64);
+  t->probs = malloc(256*256*sizeof(uint16_t));
+  t->decoded = -1;
+  return t;
+}
+
+/********************************************************************
+*                              Writer                               *
+*                                                                   *
+*  traj_create: cmax>0 stores the certainty quantised in [0,cmax]   *
+*               (use THRESHOLD: above it the zealot bit is enough); *
+*               vacancies!=0 for diluted lattices.                  *
+*  traj_write_frame: zealot and certainty may be NULL.              *
+********************************************************************/
+ladtraj *traj_create(const char *name, int width, int height, int keyinterval, double cmax, int vacancies)
+{
+  uint32_t flags = 0, version = TRAJ_VERSION;
+  ladtraj *t;
+  FILE *fp;
+
+  if ((fp = fopen(name, "wb")) == NULL) return NULL;
+  if (cmax > 0) flags |= TRAJ_CERTAINTY;
+  if (vacancies) flags |= TRAJ_VACANCY;
+  if (keyinterval < 1) keyinterval = 1;
+
+  t = traj_alloc(width, height, flags);
+  t->fp = fp;
+  t->writing = 1;
+  t->keyinterval = keyinterval;
+  t->cmax = cmax;
+
+  fwrite("LADT", 1, 4, fp);
+  fwrite(&version, sizeof version, 1, fp);
+  fwrite(&t->width, sizeof t->width, 1, fp);
+  fwrite(&t->height, sizeof t->height, 1, fp);
+  fwrite(&t->flags, sizeof t->flags, 1, fp);
+  fwrite(&t->keyinterval, sizeof t->keyinterval, 1, fp);
+  fwrite(&t->cmax, sizeof t->cmax, 1, fp);
+  fflush(fp);
+  return t;
+}
+
+int traj_write_frame(ladtraj *t, double tempo, const int *spin, const int *zealot, const double *certainty)
+{
+  unsigned char type = 0;
+  unsigned char *payload;
+  uint32_t size;
+  long c;
+
+  traj_pack(t, t->cur, spin, zealot, certainty);
+  if (t->nframes % t->keyinterval != 0) {
+    type |= TRAJ_DELTA;
+    for (long i = 0; i < t->rawsize; i++) t->work[i] = t->cur[i] ^ t->prev[i];
+  }
+  else memcpy(t->work, t->cur, t->rawsize);
+
+  c = traj_compress(t->work, t->rawsize, t->code, t->rawsize, t->probs);
+  if (c < 0) {
+    type |= TRAJ_STORED;
+    payload = t->work;
+    size = t->rawsize;
+  }
+  else {
+    payload = t->code;
+    size = c;
+  }
+
+  fwrite(&tempo, sizeof tempo, 1, t->fp);
+  fwrite(&type, 1, 1, t->fp);
+  fwrite(&size, sizeof size, 1, t->fp);
+  if (fwrite(payload, 1, size, t->fp) != size) return 0;
+  fflush(t->fp);
+
+  memcpy(t->prev, t->cur, t->rawsize);
+  t->nframes++;
+  return 1;
+}
+
+void traj_close(ladtraj *t)
+{
+  if (t == NULL) return;
+  fclose(t->fp);
+  free(t->prev);
+  free(t->cur);
+  free(t->work);
+  free(t->code);
+  free(t->probs);
+  free(t->offsets);
+  free(t->times);
+  free(t->types);
+  free(t);
+}
+
+/********************************************************************
+*                              Reader                               *
+*                                                                   *
+*  traj_open: reads the header and the frame table (one seek per    *
+*             frame, the payloads are not touched).                 *
+*  traj_read_frame: decodes frame f from the nearest keyframe,      *
+*                   or from the last decoded frame when reading     *
+*                   forward. Any of the output arrays may be NULL.  *
+********************************************************************/
+ladtraj *traj_open(const char *name)
+{
+  char magic[4];
+  uint32_t version, w, h, flags, key;
+  double cmax, tempo;
+  unsigned char type;
+  uint32_t size;
+  long cap = 1024, start, end;
+  ladtraj *t;
+  FILE *fp;
+
+  if ((fp = fopen(name, "rb")) == NULL) return NULL;
+  if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, "LADT", 4) != 0 ||
+      fread(&version, sizeof version, 1, fp) != 1 || version != TRAJ_VERSION ||
+      fread(&w, sizeof w, 1, fp) != 1 || fread(&h, sizeof h, 1, fp) != 1 ||
+      fread(&flags, sizeof flags, 1, fp) != 1 || fread(&key, sizeof key, 1, fp) != 1 ||
+      fread(&cmax, sizeof cmax, 1, fp) != 1) {
+    fclose(fp);
+    return NULL;
+  }
+
+  t = traj_alloc(w, h, flags);
+  t->fp = fp;
+  t->keyinterval = key;
+  t->cmax = cmax;
+  t->offsets = malloc(cap*sizeof(long));
+  t->times = malloc(cap*sizeof(double));
+  t->types = malloc(cap);
+
+  start = ftell(fp);
+  fseek(fp, 0, SEEK_END);
+  end = ftell(fp);
+  fseek(fp, start, SEEK_SET);
+
+  while (fread(&tempo, sizeof tempo, 1, fp) == 1 && fread(&type, 1, 1, fp) == 1 &&
+         fread(&size, sizeof size, 1, fp) == 1) {
+    long off = ftell(fp);
+    if (off + (long)size > end) break;  /* truncated last frame (killed run) */
+    fseek(fp, size, SEEK_CUR);
+    if (t->nframes == cap) {
+      cap *= 2;
+      t->offsets = realloc(t->offsets, cap*sizeof(long));
+      t->times = realloc(t->times, cap*sizeof(double));
+      t->types = realloc(t->types, cap);
+    }
+    t->offsets[t->nframes] = off;
+    t->times[t->nframes] = tempo;
+    t->types[t->nframes] = type;
+    t->nframes++;
+  }
+  return t;
+}
+
+static int traj_decode(ladtraj *t, long f)
+{
+  uint32_t size;
+
+  fseek(t->fp, t->offsets[f] - (long)sizeof size, SEEK_SET);
+  if (fread(&size, sizeof size, 1, t->fp) != 1) return 0;
+  if (t->types[f] & TRAJ_STORED) {
+    if (fread(t->work, 1, t->rawsize, t->fp) != (size_t)t->rawsize) return 0;
+  }
+  else {
+    if (fread(t->code, 1, size, t->fp) != size) return 0;
+    traj_decompress(t->code, size, t->work, t->rawsize, t->probs);
+  }
+  if (t->types[f] & TRAJ_DELTA)
+    for (long i = 0; i < t->rawsize; i++) t->prev[i] ^= t->work[i];
+  else memcpy(t->prev, t->work, t->rawsize);
+  t->decoded = f;
+  return 1;
+}
+
+int traj_read_frame(ladtraj *t, long f, double *tempo, int *spin, int *zealot, double *certainty)
+{
+  long k;
+
+  if (f < 0 || f >= t->nframes) return 0;
+  if (t->decoded >= 0 && t->decoded <= f) k = t->decoded + 1;
+  else {
+    k = f;
+    while (k > 0 && (t->types[k] & TRAJ_DELTA)) k--;
+  }
+  if (t->decoded != f)
+    for (; k <= f; k++)
+      if (!traj_decode(t, k)) return 0;
+
+  if (tempo != NULL) *tempo = t->times[f];
+  traj_unpack(t, t->prev, spin, zealot, certainty);
+  return 1;
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*************************************************************************
+*              Dilution disorder by a Newman-Ziff sweep                  *
+*                             V1.0 19/10/2026                            *
+*************************************************************************/
+
+/***************************************************************
+ *                            USAGE
+ **************************************************************/
+// gcc -O3 -DL=128 NZ_Disorder_v1.0.c -o nzdisorder -lm
+// ./nzdisorder SEED RHO [RHO ...]
+// ./nzdisorder 7 0.20 0.40 0.58 0.59 0.60 0.70 1.00
+//
+// Occupies the L x L lattice site by site in the random order of
+// the disorder seed SEED and, at every RHO, writes the occupancy
+// and the largest cluster to disorder_lg<L>_n<N>_dsd<SEED>.dis,
+// N = RHO*L*L rounded the number of agents (see disorder.h), all
+// in a single pass. The voter programs
+// built with -DDISORDER=SEED read these files instead of drawing
+// and labelling a new dilution. Prints, for each RHO, the number
+// of agents and the size of the largest cluster.
+
+/***************************************************************
+ *                            INCLUDES
+ **************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mc.h"
+#include "disorder.h"
+
+/***************************************************************
+ *                          MAIN PROGRAM
+ **************************************************************/
+int main(int argc, char *argv[]){
+
+  if(argc<3){
+    fprintf(stderr,"usage: %s SEED RHO [RHO ...]\n",argv[0]);
+    return 1;
+  }
+
+  unsigned long dseed = strtoul(argv[1],NULL,10);
+  int nrho = argc-2;
+  double *rho = malloc(nrho*sizeof(double));
+  for(int r=0; r<nrho; r++){
+    rho[r] = atof(argv[r+2]);
+    if(rho[r]<0 || rho[r]>1){
+      fprintf(stderr,"RHO = %s out of [0,1]\n",argv[r+2]);
+      return 1;
+    }
+  }
+
+  if(dis_sweep(L,dseed,nrho,rho)!=nrho)return 1;
+
+  char *mask = malloc(L*L);
+  printf("# L = %d, disorder seed = %ld\n",L,dseed);
+  printf("# Rho Agents Largest\n");
+  for(int r=0; r<nrho; r++){
+    int agents=0,largest=0;
+    dis_load(L,rho[r],dseed,mask);
+    for(int i=0; i<L*L; i++){
+      if(mask[i]!=0)agents++;
+      if(mask[i]==2)largest++;
+    }
+    printf("%.2f %d %d\n",rho[r],agents,largest);
+  }
+
+  free(mask);
+  free(rho);
+  return 0;
+}
@@ -17,7 +17,10 @@
 
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DPNGSNAPS [with SNAPSHOTS, PNG snapshots instead of EPS]
+// -DGILLESPIE [continuous time, drawing only opinion changing events and possible hops (see event driven sweep)]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -34,6 +37,9 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
+#include "occupied.h"
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -48,7 +54,7 @@
  *                            SETTINGS 
  ***************************************************************/
 
-#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 
 /***************************************************************
  *                            FUNCTIONS                       
@@ -59,8 +65,6 @@ void openfiles(void);
 void sweep(void); 
 void visualize(int,unsigned long); 
 void states(void); 
-void measures1(void); 
-void measures2(void);
 #ifdef SNAPSHOTS
   void snap(void);  
 #endif
@@ -71,19 +75,37 @@ void connections(int,int);
 int percolates2d(int);
 bool exists(const char*);
 bool probcheck(double);
+#if(GILLESPIE==1)
+  void eventinit(void);
+  void refresh(int);
+  void renew(int);
+  void hop(int,int);
+  int linkof(int,int);
+  void settle(int,double);
+  double addeta(double,long);
+  void bring(int,double);
+  void bringall(void);
+  long poisson(double);
+#endif
 
 /***************************************************************
  *                         GLOBAL VARIABLES                   
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,**neigh,*memory,*measures,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+int *spin,**neigh,*memory,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+schedule measures;
+occupied agents;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2,CONT,LINKS;
 int probperc0,probperc1;
 int hull_perimeter;
 char root_name[200];
 unsigned long seed;
 double *certainty;
+#if(GILLESPIE==1)
+int *dset,*dpos,dsize,*hset[5],*hpos,*hcls,hsize[5];
+double *tlink,tnow;
+#endif
 
 /***************************************************************
  *                          MAIN PROGRAM  
@@ -111,7 +133,12 @@ int main(void){
   initialize();
 
   #if(VISUAL==1)
-    printf("set palette defined (-2 'black',-1 '0xff4545', 0 '0xFF0000', 1 '0x81C2EF', 2 '0x0000FF')\n");
+    vis_set_color(-2,0x000000); //black
+    vis_set_color(-1,0xFF4545); //light red
+    vis_set_color(0,0xFF0000); //red
+    vis_set_color(1,0x81C2EF); //light blue
+    vis_set_color(2,0x0000FF); //blue
+    vis_palette_out();
   #endif
   for (int j=0;j<=MCS+1;j++)  {
     #if(VISUAL==1)
@@ -126,14 +153,14 @@ int main(void){
         sweep();
         states();
         hoshen_kopelman();
-        while(measures[k]!=0){
-          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f\n",measures[k],(double)sum/CONT,(double)sumz/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT);
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f\n",sched_time(&measures,k),(double)sum/CONT,(double)sumz/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT);
           fflush(fp1);
           k++;
         }           
         break;
       }
-      if (measures[k]==j) {  
+      if (sched_time(&measures,k)==j) {  
         #if(SNAPSHOTS==1)
           snap();   
           k++;        
@@ -154,6 +181,17 @@ int main(void){
   #endif
 
 }
+
+/* n increments of DETA, one at a time up to THRESHOLD as the draws
+   would add them (ten 0.1 make 0.9999999999999999, not 1), the rest
+   at once */
+double addeta(double c, long n) {
+  while(n>0 && c<THRESHOLD){
+    c += DETA;
+    n--;
+  }
+  return c + n*DETA;
+}
 /***************************************************************
  *                        INICIALIZAÇÃO  
  **************************************************************/
@@ -165,7 +203,6 @@ void initialize(void) {
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
   memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   zealot = malloc(N*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
@@ -194,6 +231,7 @@ void initialize(void) {
       spin[n] = 0;
     }
   }
+  occ_init(&agents,spin,N);
   #if(VISUAL==0)
     fprintf(fp1,"# Rho: %.1f\n",(double)CONT/N);
     fprintf(fp1,"# Time Persistence Zealots Active Clusters Big1 Perc1 Big2 Perc2\n");
@@ -225,20 +263,246 @@ void initialize(void) {
       }
     }
   }
+  #if(GILLESPIE==1)
+    eventinit();
+  #endif
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 }
 
+#if(GILLESPIE==1)
+/****************************************************************
+ *               Event driven sweep
+ *
+ *  The same dynamics as the trial sweep below, in continuous
+ *  time: each agent tries at rate 1 (CONT trials per MCS) one
+ *  of its 4 directions. Only two kinds of trials change spins
+ *  or positions, and they are drawn directly with exponential
+ *  gaps between them:
+ *   - a discordant neighbour (directed pairs in dset, rate
+ *     1/4 each): opinion update and then, with probability
+ *     MOB, a hop in a random direction if it is empty;
+ *   - an empty neighbour followed by a hop (agents in hset[n]
+ *     by their number n of empty neighbours, rate MOB n/4
+ *     times n/4: the second direction must be empty too).
+ *  A concordant pair adds DETA to both agents at rate 1/2. As
+ *  in the link update of ComplexLAD, each lattice link keeps
+ *  the time tlink[] up to which its increments were given and
+ *  settle() draws their Poisson number since then: before an
+ *  agent is reset, flips or hops (bring()) and before any
+ *  measurement (bringall()).
+ ***************************************************************/
+void sweep(void) {
+  double tend = tnow+1;
+
+  for(;;){
+    double rd = dsize/4., rh = 0;
+    for(int n=1; n<=4; n++)rh += hsize[n]*n*n;
+    rh *= MOB/16.;
+    if(rd+rh<=0)break;
+    double dt = -log(1-FRANDOM)/(rd+rh);
+    if(tnow+dt>tend)break;
+    tnow += dt;
+    if(FRANDOM*(rd+rh)<rd){
+      int e = dset[(int)(FRANDOM*dsize)];
+      int site = e/4;
+      int neighbour = neigh[site][e%4];
+      bring(site,tnow);
+      if(zealot[site] == 0){
+        memory[site]=1;
+        qt[(spin[site] + 1 )/2]--;
+        spin[site] = spin[neighbour];
+        qt[(spin[neighbour] + 1 )/2]++;
+        renew(site);
+      }
+      certainty[neighbour] += DETA;
+      certainty[site] = 0;
+      if(certainty[site]<=THRESHOLD)zealot[site]=0;
+      if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+      //Mobility
+      double RAND = FRANDOM;
+      if(RAND<=MOB){
+        neighbour = neigh[site][(int)(FRANDOM*4)];
+        if(spin[neighbour]==0)hop(site,neighbour);
+      }
+    }
+    else {
+      double r = FRANDOM*rh/(MOB/16.);
+      int n = 1;
+      while(n<4 && r>=hsize[n]*n*n){
+        r -= hsize[n]*n*n;
+        n++;
+      }
+      int site = hset[n][(int)(FRANDOM*hsize[n])];
+      int k = FRANDOM*n;
+      for(int dir=0; dir<4; dir++){
+        if(spin[neigh[site][dir]]==0 && k--==0){
+          hop(site,neigh[site][dir]);
+          break;
+        }
+      }
+    }
+  }
+  tnow = tend;
+}
+
+/* agent of site moves to the empty site v */
+void hop(int site, int v) {
+  bring(site,tnow);
+  spin[v] = spin[site];
+  certainty[v] = certainty[site];
+  zealot[v] = zealot[site];
+  memory[v] = memory[site];
+  spin[site] = 0;
+  certainty[site] = 0;
+  zealot[site] = 0;
+  memory[site] = 0;
+  occ_move(&agents,site,v);
+  renew(site);
+  renew(v);
+}
+
+/* spin or occupation of site changed: its pairs and the neighbours' */
+void renew(int site) {
+  refresh(site);
+  for(int dir=0; dir<4; dir++){
+    int w = neigh[site][dir];
+    refresh(w);
+    if(spin[site]!=0 && spin[w]==spin[site])tlink[linkof(site,dir)] = tnow;
+  }
+  activesum = dsize/2;
+}
+
+/* discordant pairs of site in dset, site in hset[empty neighbours] */
+void refresh(int site) {
+  int nv = 0;
+  for(int dir=0; dir<4; dir++){
+    int e = 4*site+dir, w = neigh[site][dir];
+    bool disc = (spin[site]!=0 && spin[w]==-spin[site]);
+    if(spin[site]!=0 && spin[w]==0)nv++;
+    if(disc && dpos[e]<0){
+      dpos[e] = dsize;
+      dset[dsize++] = e;
+    }
+    else if(!disc && dpos[e]>=0){
+      int last = dset[--dsize];
+      dset[dpos[e]] = last;
+      dpos[last] = dpos[e];
+      dpos[e] = -1;
+    }
+  }
+  if(nv==hcls[site])return;
+  if(hcls[site]>0){
+    int c = hcls[site];
+    int last = hset[c][--hsize[c]];
+    hset[c][hpos[site]] = last;
+    hpos[last] = hpos[site];
+  }
+  hcls[site] = nv;
+  if(nv>0){
+    hpos[site] = hsize[nv];
+    hset[nv][hsize[nv]++] = site;
+  }
+}
+
+/* lattice link of site in direction dir: 2*site (right), 2*site+1 (down) */
+int linkof(int site, int dir) {
+  if(dir==0)return 2*site;
+  if(dir==1)return 2*left[site];
+  if(dir==2)return 2*up[site]+1;
+  return 2*site+1;
+}
+
+/* increments of the concordant link l up to time t, to both agents */
+void settle(int l, double t) {
+  if(t<=tlink[l])return;
+  long n = poisson((t-tlink[l])/2);
+  tlink[l] = t;
+  if(n>0){
+    int i = l/2, w = (l%2==0) ? right[i] : down[i];
+    certainty[i] = addeta(certainty[i],n);
+    certainty[w] = addeta(certainty[w],n);
+    if(certainty[i]>=THRESHOLD)zealot[i]=1;
+    if(certainty[w]>=THRESHOLD)zealot[w]=1;
+  }
+}
+
+/* certainty of the agent at site brought to time t */
+void bring(int site, double t) {
+  for(int dir=0; dir<4; dir++){
+    if(spin[neigh[site][dir]]==spin[site])settle(linkof(site,dir),t);
+  }
+}
+
+void bringall(void) {
+  for(int i=0; i<N; i++){
+    if(spin[i]!=0)bring(i,tnow);
+  }
+}
+
+/****************************************************************
+ *               Event driven setup
+ ***************************************************************/
+void eventinit(void) {
+  dset = malloc(4*N*sizeof(int));
+  dpos = malloc(4*N*sizeof(int));
+  hpos = malloc(N*sizeof(int));
+  hcls = calloc(N,sizeof(int));
+  tlink = calloc(2*N,sizeof(double));
+  for(int n=1; n<=4; n++){
+    hset[n] = malloc(N*sizeof(int));
+    hsize[n] = 0;
+  }
+  if(dset==NULL || dpos==NULL || hpos==NULL || hcls==NULL || tlink==NULL || hset[4]==NULL){
+    fprintf(stderr,"no memory for the event driven sweep\n");
+    exit(1);
+  }
+  dsize = 0;
+  tnow = 0;
+  for(int e=0; e<4*N; e++)dpos[e] = -1;
+  for(int i=0; i<N; i++)refresh(i);
+}
+
+/****************************************************************
+ *               Poisson numbers
+ *
+ *  Inversion for small means, transformed rejection (PTRS,
+ *  Hormann 1993) for the others.
+ ***************************************************************/
+long poisson(double mu) {
+  if(mu<10){
+    double p = exp(-mu), f = p, u = FRANDOM;
+    long n = 0;
+    while(u>f && n<1000){
+      n++;
+      p *= mu/n;
+      f += p;
+    }
+    return n;
+  }
+  double slam = sqrt(mu), loglam = log(mu);
+  double b = 0.931 + 2.53*slam, a = -0.059 + 0.02483*b;
+  double invalpha = 1.1239 + 1.1328/(b-3.4), vr = 0.9277 - 3.6224/(b-2);
+  for(;;){
+    double u = FRANDOM-0.5, v = FRANDOM, us = 0.5-fabs(u);
+    long k = (long)floor((2*a/us + b)*u + mu + 0.43);
+    if(us>=0.07 && v<=vr)return k;
+    if(k<0 || (us<0.013 && v>us))continue;
+    if(log(v) + log(invalpha) - log(a/(us*us)+b) <= -mu + k*loglam - lgamma(k+1))return k;
+  }
+}
+#else
 /****************************************************************
  *               MCS routine
  ***************************************************************/
 void sweep(void) {
   for (int n=0; n<CONT; n++) {
-    int site = FRANDOM*N;
-    while (spin[site]==0)site = FRANDOM*N;
+    int site = occ_pick(&agents);
     //Opinion dynamics    
     int dir = FRANDOM*4;
     int neighbour = neigh[site][dir];
@@ -288,7 +552,7 @@ void sweep(void) {
         int focalspin = spin[site];
         spin[site]=spin[neighbour];
         spin[neighbour]=focalspin;
-        int focalconf = certainty[site];
+        double focalconf = certainty[site];
         certainty[site]=certainty[neighbour];
         certainty[neighbour]=focalconf;
         int focalz = zealot[site];
@@ -297,6 +561,7 @@ void sweep(void) {
         int focalmemory = memory[site];
         memory[site]=memory[neighbour];
         memory[neighbour]=focalmemory;
+        occ_move(&agents,site,neighbour);
         int INTERFDEPOIS=0;
         if(spin[up[neighbour]]==-spin[neighbour])INTERFDEPOIS++;
         if(spin[right[neighbour]]==-spin[neighbour])INTERFDEPOIS++;
@@ -308,10 +573,15 @@ void sweep(void) {
   }
 }
 
+#endif
+
 /****************************************************************
  *               Check states numbers
  ***************************************************************/
 void states(void) {
+  #if(GILLESPIE==1)
+    bringall();
+  #endif
   sum=CONT;
   sumz=0;
   LINKS=0;
@@ -325,37 +595,6 @@ void states(void) {
     }
   }
 }
- /**************************************************************
- *                       Measures Vector     // Medidas Logarítmicas
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
-    }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
- /**************************************************************
- *                       Measures Vector    // Número de medidas
- *************************************************************/
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
-  }
-  return;
-}
-
 /**************************************************************
  *                      Teste
  *************************************************************/
@@ -371,18 +610,23 @@ bool probcheck(double _ALPHA) {
  *************************************************************/
 void visualize(int _j,unsigned long _seed) {
   int l;
-  printf("pl '-' matrix w image t 'time = %d seed = %ld'\n",_j,_seed);
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
+  #if(GILLESPIE==1)
+    bringall();
+  #endif
   for(l = N-1; l >= 0; l--) {
     if(spin[l]!=0){  
-      if(zealot[l]==1)printf("%d ", spin[l]+1);
-      else printf("%d ", spin[l]);
+      if(zealot[l]==1)cell[N-1-l]=spin[l]+1;
+      else cell[N-1-l]=spin[l];
     }
     else{
-      printf("%d ", -2);
+      cell[N-1-l]=-2;
     }
-    if( l%L == 0 ) printf("\n");
   }
-  printf("e\n");
+  snprintf(title,sizeof title,"time = %d seed = %ld",_j,_seed);
+  vis_emit(title);
 }
 
 #ifdef SNAPSHOTS
@@ -393,6 +637,10 @@ void visualize(int _j,unsigned long _seed) {
     int l;
     int identifier = 0;
     char teste[100];
+    uint8_t *frame = malloc(N*sizeof(uint8_t));
+    #if(GILLESPIE==1)
+      bringall();
+    #endif
 
     lat2eps_init(L,L);
     lat2eps_set_color(0,0x00000); //black
@@ -406,22 +654,33 @@ void visualize(int _j,unsigned long _seed) {
 
     for(l=0; l<N; l++) {
       if(spin[l]==1) {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,4);
-        else lat2eps_set_site(l%L,l/L,6);
+        if(certainty[l]>=1)frame[l]=4;
+        else frame[l]=6;
       }
       else {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,5);
-        else lat2eps_set_site(l%L,l/L,7);
+        if(certainty[l]>=1)frame[l]=5;
+        else frame[l]=7;
       } 
     }
 
-    snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+    #ifdef PNGSNAPS
+      const char *ext = "png";
+    #else
+      const char *ext = "eps";
+    #endif
+    snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     while(exists(teste)==true) {
       identifier++;
-      snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+      snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     }
-    lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #ifdef PNGSNAPS
+      lat2eps_gen_raster(teste,frame,L,L,3,LAT2EPS_PNG);
+    #else
+      lat2eps_set_lattice(frame);
+      lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #endif
     lat2eps_release();
+    free(frame);
   }
 #endif
 
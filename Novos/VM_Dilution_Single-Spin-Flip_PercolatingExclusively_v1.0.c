@@ -14,7 +14,9 @@
 
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DDISORDER=7 [dilution from the disorder seed 7, read from disorder_lg<L>_n<RHO*L*L>_dsd7.dis or swept if missing (see disorder.h, NZ_Disorder_v1.0.c)]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -31,6 +33,11 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
+#ifdef DISORDER
+  #include "disorder.h"
+#endif
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -47,7 +54,7 @@
  *                            SETTINGS 
  ***************************************************************/
 
-#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 
 /***************************************************************
  *                            FUNCTIONS                       
@@ -59,12 +66,12 @@ void sweep(void);
 void visualize(double,unsigned long); 
 void visualize_percolating(double,unsigned long);
 void states(void); 
-void measures1(void); 
-void measures2(void);
 void listremove(int);
 void listinclude(int);
 void single_update(int);
 void updatelist(int);
+void compact(void);
+void unpack(void);
 #ifdef SNAPSHOTS
   void snap(void);  
 #endif
@@ -81,7 +88,9 @@ bool probcheck(double);
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,*refperc,*list,*listaux,**neigh,*memory,*measures,*right,*left,*up, *down, sum, sumz, activesum,BIGST;
+int *spin,*list,*listaux,**neigh,*right,*left,*up, *down, sum, sumz, activesum,BIGST;
+int *psite,*poff,*padj,*pspin,*pmemory;
+schedule measures;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2,CONT,LINKS;
 int NACTIVE,probperc0,probperc1;
 int hull_perimeter;
@@ -116,21 +125,21 @@ int main(void){
         states();
         fprintf(fp1,"%.8f %.8f %.8f %.8f %d\n",tempo,(double)sum/CONT,(double)activesum/LINKS,(double)qt[0]/CONT,NACTIVE);
         fflush(fp1);
-        while(measures[k]!=0){
-          fprintf(fp1,"%.8f %.8f %.8f %.8f %d\n",(double)measures[k],(double)sum/CONT,(double)activesum/LINKS,(double)qt[0]/CONT,NACTIVE);
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%.8f %.8f %.8f %.8f %d\n",(double)sched_time(&measures,k),(double)sum/CONT,(double)activesum/LINKS,(double)qt[0]/CONT,NACTIVE);
           fflush(fp1);
           k++;
         }           
         break;
     }
-    if (tempo >= measures[k]) {  
+    if (tempo >= sched_time(&measures,k)) {  
       states();
       fprintf(fp1,"%.8f %.8f %.8f %.8f %d\n",tempo,(double)sum/CONT,(double)activesum/LINKS,(double)qt[0]/CONT,NACTIVE);
       fflush(fp1);
       k++;
     }
     int agent = FRANDOM*NACTIVE;
-    int site = list[agent];
+    int node = list[agent];
     #if(VISUAL==1)
       if(tempo>contagem){
         visualize(tempo,seed);
@@ -143,7 +152,7 @@ int main(void){
         contagem++;
       }
     #endif    
-    single_update(site);
+    single_update(node);
   }
 
   #if(SNAPSHOTS==0)
@@ -156,35 +165,37 @@ int main(void){
  **************************************************************/
 void initialize(void) {
  
+  #ifdef DISORDER
+    char *mask = malloc(N);
+    dis_get(L,RHO,DISORDER,mask);
+  #endif
   start_randomic(seed);
 
-  his = malloc(N*sizeof(int));
+  his = malloc((N+1)*sizeof(int));
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
-  memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
   up = malloc(N*sizeof(int));
   down = malloc(N*sizeof(int));
-  list = malloc(N*sizeof(int));
-  listaux = malloc(N*sizeof(int));
-  refperc = malloc(N*sizeof(int));
   #if(NBINARY==0)
-    qt = malloc(2*sizeof(int));
+    qt = calloc(2,sizeof(int));
   #else
-    qt = malloc(N*sizeof(int));
+    qt = calloc(N,sizeof(int));
   #endif
 
   for(int i=0; i<N; i++){
     neigh[i] = (int*)malloc(4*sizeof(int));
   }
 
-  CONT=0;
   for(int n=0; n<N; n++) { 
-    double RAND = FRANDOM;
-    memory[n] = 0;
-    if(RAND<=RHO){      
+    #ifdef DISORDER
+      int occupied = (mask[n]!=0);
+    #else
+      double RAND = FRANDOM;
+      int occupied = (RAND<=RHO);
+    #endif
+    if(occupied){      
       int k=FRANDOM*2;
       spin[n] = k*2 - 1; 
     }
@@ -204,36 +215,47 @@ void initialize(void) {
     down[i] = neigh[i][3];
   }
 
-  structure_hoshen_kopelman();
+  #ifdef DISORDER
+    label = malloc(N*sizeof(int));
+    BIGST = -1;
+    mx1 = 0;
+    for (int i=0; i<N; i++) {
+      label[i] = i;
+      if(mask[i]==2){
+        if(BIGST==-1)BIGST=i;
+        label[i] = BIGST;
+        mx1++;
+      }
+    }
+    probperc0 = percolates2d(BIGST);
+    free(mask);
+  #else
+    structure_hoshen_kopelman();
+  #endif
+  compact();
+
+  list = malloc(CONT*sizeof(int));
+  listaux = malloc(CONT*sizeof(int));
 
   LINKS=0;
   NACTIVE=0;
-  for (int i=0; i<N; i++) {
-    listaux[i]=-1;
+  for (int c=0; c<CONT; c++) {
+    listaux[c]=-1;
     int relative=0;
-    if(label[i]==BIGST){
-      qt[(spin[i]+1)/2]++;
-      refperc[i]=1;
-      CONT++;
-      for(int j=0;j<4;j++)if(spin[neigh[i][j]] == -spin[i])relative=1;
-      if (label[right[i]]==BIGST){
-        LINKS++;
-        if(spin[right[i]]!=spin[i]){
-          activesum++;
-        }
-      }
-      if (label[down[i]]==BIGST){
+    qt[(pspin[c]+1)/2]++;
+    for(int e=poff[c]; e<poff[c+1]; e++){
+      int viz = padj[e];
+      if(pspin[viz] == -pspin[c])relative=1;
+      if(viz>c){
         LINKS++;
-        if(spin[down[i]]!=spin[i]){
-          activesum++;
-        }
-      }
-      if(relative==1){
-        list[NACTIVE]=i;
-        listaux[i]=NACTIVE;
-        NACTIVE++;
+        if(pspin[viz]!=pspin[c])activesum++;
       }
     }
+    if(relative==1){
+      list[NACTIVE]=c;
+      listaux[c]=NACTIVE;
+      NACTIVE++;
+    }
   }
 
   #if(VISUAL==0)
@@ -245,36 +267,93 @@ void initialize(void) {
 
   
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 }
+/****************************************************************
+ *               Percolating cluster as a compact graph
+ *
+ * Only the agents of the largest cluster take part in the
+ * dynamics. They are renumbered 0..CONT-1 (psite[c] is the
+ * lattice site of node c) and their occupied neighbours, all in
+ * the same cluster, are stored in CSR form: padj[poff[c]] to
+ * padj[poff[c+1]-1], in the order right, left, up, down. The
+ * lattice arrays are released afterwards; spin[] and label[] are
+ * kept for the frames, filled back by unpack().
+ ***************************************************************/
+void compact(void) {
+  int *node = malloc(N*sizeof(int));
+
+  CONT=0;
+  for (int i=0; i<N; i++) {
+    if(spin[i]!=0 && label[i]==BIGST)node[i]=CONT++;
+    else node[i]=-1;
+  }
+
+  psite = malloc(CONT*sizeof(int));
+  poff = malloc((CONT+1)*sizeof(int));
+  pspin = malloc(CONT*sizeof(int));
+  pmemory = calloc(CONT,sizeof(int));
+
+  poff[0]=0;
+  for (int i=0; i<N; i++) {
+    if(node[i]==-1)continue;
+    int c = node[i];
+    psite[c] = i;
+    pspin[c] = spin[i];
+    poff[c+1] = poff[c];
+    for(int j=0;j<4;j++)if(node[neigh[i][j]]!=-1)poff[c+1]++;
+  }
+
+  padj = malloc(poff[CONT]*sizeof(int));
+  for (int c=0; c<CONT; c++) {
+    int e = poff[c];
+    for(int j=0;j<4;j++){
+      int viz = node[neigh[psite[c]][j]];
+      if(viz!=-1)padj[e++]=viz;
+    }
+  }
+
+  free(node);
+  for(int i=0; i<N; i++)free(neigh[i]);
+  free(neigh);
+  free(right);
+  free(left);
+  free(up);
+  free(down);
+  free(siz);
+  free(his);
+}
+
+void unpack(void) {
+  for (int c=0; c<CONT; c++)spin[psite[c]]=pspin[c];
+}
+
 /****************************************************************
  *               Single_Update
+ *
+ * A draw of one of the 4 directions; a vacancy leaves the agent
+ * unchanged, as on the lattice.
  ***************************************************************/
-void single_update(int _site) {
+void single_update(int _node) {
   //Opinion dynamics    
   int dir = FRANDOM*4;
-  int neighbour = neigh[_site][dir];
-  if(spin[_site]==-spin[neighbour]) {
+  int first = poff[_node];
+  int degree = poff[_node+1] - first;
+  if(dir<degree && pspin[_node]==-pspin[padj[first+dir]]) {
     int INTERFANTES=0;
-    if(spin[up[_site]]==-spin[_site])INTERFANTES++;
-    if(spin[right[_site]]==-spin[_site])INTERFANTES++;
-    if(spin[down[_site]]==-spin[_site])INTERFANTES++;
-    if(spin[left[_site]]==-spin[_site])INTERFANTES++;
-    memory[_site]=1;
-    qt[(spin[_site] + 1 )/2]--;
-    spin[_site] = spin[neighbour];
-    qt[(spin[neighbour] + 1 )/2]++;
-    int INTERFDEPOIS=0;
-    if(spin[up[_site]]==-spin[_site])INTERFDEPOIS++;
-    if(spin[right[_site]]==-spin[_site])INTERFDEPOIS++;
-    if(spin[down[_site]]==-spin[_site])INTERFDEPOIS++;
-    if(spin[left[_site]]==-spin[_site])INTERFDEPOIS++;
-    activesum+=(INTERFDEPOIS-INTERFANTES);
+    for(int e=first; e<first+degree; e++)if(pspin[padj[e]]==-pspin[_node])INTERFANTES++;
+    pmemory[_node]=1;
+    qt[(pspin[_node] + 1 )/2]--;
+    pspin[_node] = -pspin[_node];
+    qt[(pspin[_node] + 1 )/2]++;
+    activesum+=(degree-2*INTERFANTES);
     tempo+=1./NACTIVE;
-    updatelist(_site);
+    updatelist(_node);
   }
   else tempo+=1./NACTIVE;
 }
@@ -284,109 +363,84 @@ void single_update(int _site) {
  ***************************************************************/
 void states(void) {
   sum=CONT;
-  for (int i=0; i<N; i++) {
-    if(memory[i]!=0)sum--;
+  for (int c=0; c<CONT; c++) {
+    if(pmemory[c]!=0)sum--;
   }
 }
 
 /**************************************************************
  *              List management                  
  *************************************************************/
-void listremove(int _site){
-  int agent = listaux[_site];
+void listremove(int _node){
+  int agent = listaux[_node];
   list[agent] = list[(NACTIVE-1)];
   listaux[list[agent]]=agent;
-  listaux[_site]=-1;
+  listaux[_node]=-1;
   NACTIVE--;
 }
 
-void listinclude(int _site){
-  list[NACTIVE] = _site;
-  listaux[_site] = NACTIVE;
+void listinclude(int _node){
+  list[NACTIVE] = _node;
+  listaux[_node] = NACTIVE;
   NACTIVE++;
 }
 
-void updatelist(int _site){
+void updatelist(int _node){
   int cont=0;
   int cont2;
-  for(int i=0; i<4; i++){
-    int viz = neigh[_site][i];
-    if(spin[viz] == -spin[_site])cont=1;
+  for(int e=poff[_node]; e<poff[_node+1]; e++){
+    int viz = padj[e];
+    if(pspin[viz] == -pspin[_node])cont=1;
     cont2=0;
-    if(spin[viz]!=0){
-      for(int j=0; j<4; j++){
-        int vizviz = neigh[viz][j];
-        if(spin[vizviz] == -spin[viz])cont2=1;
-      }
-      if(cont2==0){
-        if(listaux[viz]!=-1)listremove(viz);
-      }
-      else{
-        if(listaux[viz]==-1)listinclude(viz);
-      }
+    for(int f=poff[viz]; f<poff[viz+1]; f++){
+      if(pspin[padj[f]] == -pspin[viz])cont2=1;
     }
-  }
-  if(cont == 0)listremove(_site); 
-}
-
- /**************************************************************
- *                       Measures Vector 
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
+    if(cont2==0){
+      if(listaux[viz]!=-1)listremove(viz);
+    }
+    else{
+      if(listaux[viz]==-1)listinclude(viz);
     }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
   }
-  return;
+  if(cont == 0)listremove(_node); 
 }
 
 /**************************************************************
  *                       Vizualização                   
  *************************************************************/
 void visualize(double _j,unsigned long _seed) {
-  printf("pl '-' matrix w image t 'time = %.8f seed = %ld'\n",_j,_seed);
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
+  unpack();
   for(int l = 0; l < N; l++) {
     if(spin[l]!=0){  
-      printf("%d ", spin[l]);
+      cell[l]=spin[l];
     }
     else{
-      printf("%d ", -2);
+      cell[l]=-2;
     }
-    if( (l+1)%L == 0 ) printf("\n");
   }
-  printf("e\n");
+  snprintf(title,sizeof title,"time = %.8f seed = %ld",_j,_seed);
+  vis_emit(title);
 }
 
 void visualize_percolating(double _j,unsigned long _seed) {
-  printf("pl '-' matrix w image t 'time = %.8f seed = %ld'\n",_j,_seed);
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
+  unpack();
   for(int l = 0; l < N; l++) {
     if(spin[l]!=0){  
-      if(label[l]==BIGST)printf("%d ", spin[l]);
-      else printf("%d ", -2);
+      if(label[l]==BIGST)cell[l]=spin[l];
+      else cell[l]=-2;
     }
     else{
-      printf("%d ", -2);
+      cell[l]=-2;
     }
-    if( (l+1)%L == 0 ) printf("\n");
   }
-  printf("e\n");
+  snprintf(title,sizeof title,"time = %.8f seed = %ld",_j,_seed);
+  vis_emit(title);
 }
 
 
@@ -560,6 +614,9 @@ void openfiles(void) {
   fprintf(fp1,"# Generated with: VM_Dilution_Single-Spin-Flip_PercolatingExclusively_v1.0\n");
   fprintf(fp1,"# Seed: %ld\n",seed);
   fprintf(fp1,"# Linear size: %d\n",L);
+  #ifdef DISORDER
+    fprintf(fp1,"# Disorder seed: %d\n",DISORDER);
+  #endif
   fflush(fp1);
 
   return;
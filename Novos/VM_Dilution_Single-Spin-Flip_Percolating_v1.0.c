@@ -14,6 +14,7 @@
 
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
 
 /***************************************************************
@@ -31,6 +32,8 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -47,7 +50,7 @@
  *                            SETTINGS 
  ***************************************************************/
 
-#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 
 /***************************************************************
  *                            FUNCTIONS                       
@@ -59,8 +62,6 @@ void sweep(void);
 void visualize(double,unsigned long); 
 void visualize_percolating(double,unsigned long);
 void states(void); 
-void measures1(void); 
-void measures2(void);
 void listremove(int);
 void listinclude(int);
 void single_update(int);
@@ -81,7 +82,8 @@ bool probcheck(double);
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,*refperc,*list,*listaux,**neigh,*memory,*measures,*right,*left,*up, *down, sum, sumz, activesum,BIGST;
+int *spin,*refperc,*list,*listaux,**neigh,*memory,*right,*left,*up, *down, sum, sumz, activesum,BIGST;
+schedule measures;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2,CONT,LINKS;
 int NACTIVE,probperc0,probperc1;
 int hull_perimeter;
@@ -116,14 +118,14 @@ int main(void){
         states();
         fprintf(fp1,"%.8f %.8f %.8f %.8f %d\n",tempo,(double)sum/CONT,(double)activesum/LINKS,(double)qt[0]/CONT,NACTIVE);
         fflush(fp1);
-        while(measures[k]!=0){
-          fprintf(fp1,"%.8f %.8f %.8f %.8f %d\n",(double)measures[k],(double)sum/CONT,(double)activesum/LINKS,(double)qt[0]/CONT,NACTIVE);
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%.8f %.8f %.8f %.8f %d\n",(double)sched_time(&measures,k),(double)sum/CONT,(double)activesum/LINKS,(double)qt[0]/CONT,NACTIVE);
           fflush(fp1);
           k++;
         }           
         break;
     }
-    if (tempo >= measures[k]) {  
+    if (tempo >= sched_time(&measures,k)) {  
       states();
       fprintf(fp1,"%.8f %.8f %.8f %.8f %d\n",tempo,(double)sum/CONT,(double)activesum/LINKS,(double)qt[0]/CONT,NACTIVE);
       fflush(fp1);
@@ -156,7 +158,6 @@ void initialize(void) {
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
   memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
   up = malloc(N*sizeof(int));
@@ -240,9 +241,11 @@ void initialize(void) {
     }
   }
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 }
 /****************************************************************
@@ -331,64 +334,40 @@ void updatelist(int _site){
   if(cont == 0)listremove(_site); 
 }
 
- /**************************************************************
- *                       Measures Vector 
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
-    }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
-  }
-  return;
-}
-
 /**************************************************************
  *                       Vizualização                   
  *************************************************************/
 void visualize(double _j,unsigned long _seed) {
-  printf("pl '-' matrix w image t 'time = %.8f seed = %ld'\n",_j,_seed);
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
   for(int l = 0; l < N; l++) {
     if(spin[l]!=0){  
-      printf("%d ", spin[l]);
+      cell[l]=spin[l];
     }
     else{
-      printf("%d ", -2);
+      cell[l]=-2;
     }
-    if( (l+1)%L == 0 ) printf("\n");
   }
-  printf("e\n");
+  snprintf(title,sizeof title,"time = %.8f seed = %ld",_j,_seed);
+  vis_emit(title);
 }
 
 void visualize_percolating(double _j,unsigned long _seed) {
-  printf("pl '-' matrix w image t 'time = %.8f seed = %ld'\n",_j,_seed);
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
   for(int l = 0; l < N; l++) {
     if(spin[l]!=0){  
-      if(label[l]==BIGST)printf("%d ", spin[l]);
-      else printf("%d ", -2);
+      if(label[l]==BIGST)cell[l]=spin[l];
+      else cell[l]=-2;
     }
     else{
-      printf("%d ", -2);
+      cell[l]=-2;
     }
-    if( (l+1)%L == 0 ) printf("\n");
   }
-  printf("e\n");
+  snprintf(title,sizeof title,"time = %.8f seed = %ld",_j,_seed);
+  vis_emit(title);
 }
 
 
@@ -15,7 +15,9 @@
 
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DCHECKPOINT=600 [checkpoint every 600 s of wall time, a new run of the same parameters resumes a dead one (see checkpoint.h)]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -32,6 +34,14 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
+#ifdef CHECKPOINT
+  #if((VISUAL==1)||(SNAPSHOTS==1))
+    #error "CHECKPOINT needs the output files (no VISUAL or SNAPSHOTS)"
+  #endif
+  #include "checkpoint.h"
+#endif
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -48,7 +58,7 @@
  *                            SETTINGS 
  ***************************************************************/
 
-#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    1 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 
 /***************************************************************
  *                            FUNCTIONS                       
@@ -59,8 +69,6 @@ void openfiles(void);
 void sweep(void); 
 void visualize(double,unsigned long); 
 void states(void); 
-void measures1(void); 
-void measures2(void);
 void listremove(int);
 void listinclude(int);
 void single_update(int);
@@ -75,19 +83,25 @@ void connections(int,int);
 int percolates2d(int);
 bool exists(const char*);
 bool probcheck(double);
+#ifdef CHECKPOINT
+  void checkpoint(int);
+  void restore(int*);
+#endif
 
 /***************************************************************
  *                         GLOBAL VARIABLES                   
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,*list,*listaux,**neigh,*memory,*measures,*right,*left,*up, *down, sum, sumz, activesum;
+int *spin,*list,*listaux,**neigh,*memory,*right,*left,*up, *down, sum, sumz, activesum;
+schedule measures;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2,CONT,LINKS;
 int NACTIVE,probperc0,probperc1;
 int hull_perimeter;
 char root_name[200];
 unsigned long seed;
 double tempo;
+int resumed=0;
 
 /***************************************************************
  *                          MAIN PROGRAM  
@@ -110,21 +124,31 @@ int main(void){
 
   int k=0;
   initialize();
+  #ifdef CHECKPOINT
+    int ckcheck=0;
+    if(resumed==1)restore(&k);
+  #endif
   int contagem=0;
   while(tempo <= MCS){
+    #ifdef CHECKPOINT
+      if(tempo>=ckcheck){
+        ckcheck=(int)tempo+1;
+        if(ck_due(CHECKPOINT))checkpoint(k);
+      }
+    #endif
     if( NACTIVE == 0 ){
         states();
         hoshen_kopelman();
         fprintf(fp1,"%.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f %d\n",tempo,(double)sum/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT,NACTIVE);
         fflush(fp1);
-        while(measures[k]!=0){
-          fprintf(fp1,"%.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f %d\n",(double)measures[k],(double)sum/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT,NACTIVE);
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f %d\n",(double)sched_time(&measures,k),(double)sum/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT,NACTIVE);
           fflush(fp1);
           k++;
         }           
         break;
     }
-    if (tempo >= measures[k]) {  
+    if (tempo >= sched_time(&measures,k)) {  
       states();
       hoshen_kopelman();
       fprintf(fp1,"%.8f %.8f %.8f %.8f %.8f %d %.8f %d %.8f %d\n",tempo,(double)sum/CONT,(double)activesum/LINKS,(double)numc/CONT,(double)mx1/CONT,probperc0,(double)mx2/CONT,probperc1,(double)qt[0]/CONT,NACTIVE);
@@ -147,6 +171,9 @@ int main(void){
   #if(SNAPSHOTS==0)
   fclose(fp1);
   #endif
+  #ifdef CHECKPOINT
+    ck_done(root_name,seed);
+  #endif
 
 }
 /***************************************************************
@@ -160,7 +187,6 @@ void initialize(void) {
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
   memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
   up = malloc(N*sizeof(int));
@@ -239,9 +265,11 @@ void initialize(void) {
     }
   }
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 }
 /****************************************************************
@@ -327,49 +355,23 @@ void updatelist(int _site){
   if(cont == 0)listremove(_site); 
 }
 
- /**************************************************************
- *                       Measures Vector 
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
-    }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
-  }
-  return;
-}
-
 /**************************************************************
  *                       Vizualização                   
  *************************************************************/
 void visualize(double _j,unsigned long _seed) {
-  printf("pl '-' matrix w image t 'time = %.8f seed = %ld'\n",_j,_seed);
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
   for(int l = 0; l < N; l++) {
     if(spin[l]!=0){  
-      printf("%d ", spin[l]);
+      cell[l]=spin[l];
     }
     else{
-      printf("%d ", -2);
+      cell[l]=-2;
     }
-    if( (l+1)%L == 0 ) printf("\n");
   }
-  printf("e\n");
+  snprintf(title,sizeof title,"time = %.8f seed = %ld",_j,_seed);
+  vis_emit(title);
 }
 
 
@@ -529,9 +531,12 @@ void openfiles(void) {
   sprintf(root_name,"datavoterdillution_lg%d_rho%.2f",L,RHO);
 
   unsigned long identifier = seed;
+  #ifdef CHECKPOINT
+    resumed = ck_claim(root_name,&identifier);
+  #endif
   #if(DEBUG==0)
     sprintf(teste,"%s_sd%ld_1.dsf",root_name,identifier);
-    while(exists(teste)==true) {
+    while((resumed==0)&&(exists(teste)==true)) {
       identifier+=2;
       sprintf(teste,"%s_sd%ld_1.dsf",root_name,identifier);
     }
@@ -539,9 +544,16 @@ void openfiles(void) {
   sprintf(teste,"%s_sd%ld",root_name,identifier);
   
   seed=identifier;
+  #ifdef CHECKPOINT
+    if(resumed==0)ck_lock(root_name,seed);
+  #endif
 
   sprintf(output_file1,"%s_1.dsf",teste);
-  fp1 = fopen(output_file1,"w");
+  fp1 = fopen(output_file1,(resumed==1)?"r+":"w");
+  if(fp1==NULL){
+    fprintf(stderr,"%s can not be opened\n",output_file1);
+    exit(1);
+  }
   fprintf(fp1,"# Generated with: VM_Dilution_Single-Spin-Flip_v1.0\n");
   fprintf(fp1,"# Seed: %ld\n",seed);
   fprintf(fp1,"# Linear size: %d\n",L);
@@ -551,3 +563,58 @@ void openfiles(void) {
   
 }
 
+#ifdef CHECKPOINT
+/**************************************************************
+ *               Checkpoint / restart routines
+ *************************************************************/
+
+int ckstate(ckblock *b, int *k, long *length) {
+  int nb=0;
+  b[nb++] = (ckblock)CK_VAR(seed);
+  b[nb++] = (ckblock)CK_VAR(tempo);
+  b[nb++] = (ckblock){"k",k,sizeof(int)};
+  b[nb++] = (ckblock){"length1",length,sizeof(long)};
+  b[nb++] = (ckblock)CK_ARRAY(spin,N);
+  b[nb++] = (ckblock)CK_ARRAY(memory,N);
+  #if(NBINARY==0)
+    b[nb++] = (ckblock)CK_ARRAY(qt,2);
+  #else
+    b[nb++] = (ckblock)CK_ARRAY(qt,N);
+  #endif
+  b[nb++] = (ckblock)CK_ARRAY(list,N);
+  b[nb++] = (ckblock)CK_ARRAY(listaux,N);
+  b[nb++] = (ckblock)CK_VAR(NACTIVE);
+  b[nb++] = (ckblock)CK_VAR(activesum);
+  b[nb++] = (ckblock)CK_VAR(CONT);
+  b[nb++] = (ckblock)CK_VAR(LINKS);
+  b[nb++] = (ckblock)CK_VAR(ira);
+  b[nb++] = (ckblock)CK_VAR(ip);
+  b[nb++] = (ckblock)CK_VAR(ip1);
+  b[nb++] = (ckblock)CK_VAR(ip2);
+  b[nb++] = (ckblock)CK_VAR(ip3);
+  return nb;
+}
+
+void checkpoint(int k) {
+  ckblock b[20];
+  long length;
+
+  fflush(fp1);
+  fsync(fileno(fp1));
+  length = ftell(fp1);
+  if(ck_save(root_name,seed,b,ckstate(b,&k,&length))==0){
+    fprintf(stderr,"checkpoint of %s_sd%ld can not be written\n",root_name,seed);
+  }
+}
+
+void restore(int *k) {
+  ckblock b[20];
+  long length;
+
+  if(ck_load(root_name,seed,b,ckstate(b,k,&length))==0){
+    fprintf(stderr,"checkpoint of %s_sd%ld is corrupted or from another build\n",root_name,seed);
+    exit(1);
+  }
+  ck_truncate(fp1,length);
+}
+#endif
@@ -0,0 +1,210 @@
+/********************************************************************
+***                   Quenched Dilution Disorder                  ***
+***                   Last Modified: 19/10/2026                   ***
+***                                                               ***
+***  Newman-Ziff sweep: the N sites of the L x L periodic lattice ***
+***  are occupied one at a time in a random order (drawn from the ***
+***  disorder seed), the clusters kept in a union-find forest. At ***
+***  n = RHO*N occupied sites (rounded) the occupancy and the     ***
+***  largest cluster are stored in disorder_lg<L>_n<n>_dsd<seed>  ***
+***  .dis, so a single pass gives every RHO of a seed and all the ***
+***  voter samples of (L,n,seed) share the same mask. The name    ***
+***  holds the number of agents n instead of RHO: two RHO that    ***
+***  round to the same n share one file, two that do not never    ***
+***  collide. The file layout is                                  ***
+***                                                               ***
+***     "LADDIS" 0 0 | L | rho | seed | n | largest | mask[N]     ***
+***                                                               ***
+***  with mask 0 (vacancy), 1 (agent) or 2 (agent of the largest  ***
+***  cluster). Since the order is a permutation, the number of    ***
+***  agents is fixed (n) instead of binomial around RHO*N.        ***
+***  Include after mc.h; the sweep reseeds the generator.         ***
+***                                                               ***
+***  dis_sweep(l,seed,nrho,rho)   write the files of all the rho  ***
+***  dis_load(l,rho,seed,mask)    read one, 0 if missing or bad   ***
+***  dis_get(l,rho,seed,mask)     read one, sweeping if missing   ***
+********************************************************************/
+
+#ifndef DISORDER_H
+#define DISORDER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char dis_magic[8] = "LADDIS\0\0";
+
+/********************************************************************
+*                         File names                                *
+********************************************************************/
+int dis_count(int l, double rho)
+{
+  return (int)(rho*l*l + 0.5);
+}
+
+void dis_name(char *name, size_t len, int l, double rho, unsigned long seed)
+{
+  snprintf(name,len,"disorder_lg%d_n%d_dsd%ld.dis",l,dis_count(l,rho),seed);
+}
+
+/********************************************************************
+*                    Union-find (Newman-Ziff)                       *
+*                                                                   *
+*  ptr[i] < 0: root of a cluster of -ptr[i] sites                   *
+*  ptr[i] = nz_empty: vacancy                                       *
+********************************************************************/
+int nz_empty;
+
+int nz_find(int *ptr, int i)
+{
+  while (ptr[i] >= 0) {
+    if (ptr[ptr[i]] >= 0) ptr[i] = ptr[ptr[i]];
+    i = ptr[i];
+  }
+  return i;
+}
+
+int nz_union(int *ptr, int r1, int r2)
+{
+  if (r1 == r2) return r1;
+  if (ptr[r1] > ptr[r2]) {
+    int t = r1; r1 = r2; r2 = t;
+  }
+  ptr[r1] += ptr[r2];
+  ptr[r2] = r1;
+  return r1;
+}
+
+/********************************************************************
+*                        Write one mask                             *
+********************************************************************/
+int dis_save(int l, double rho, unsigned long seed, int n, int largest, const char *mask)
+{
+  char name[300],tmp[310];
+  int size = l*l;
+  int ok;
+  FILE *fp;
+
+  dis_name(name,sizeof name,l,rho,seed);
+  snprintf(tmp,sizeof tmp,"%s.%d.tmp",name,(int)getpid());
+  fp = fopen(tmp,"wb");
+  if (fp == NULL) return 0;
+
+  ok = (fwrite(dis_magic,1,8,fp) == 8);
+  ok = ok && (fwrite(&l,4,1,fp) == 1);
+  ok = ok && (fwrite(&rho,8,1,fp) == 1);
+  ok = ok && (fwrite(&seed,sizeof seed,1,fp) == 1);
+  ok = ok && (fwrite(&n,4,1,fp) == 1);
+  ok = ok && (fwrite(&largest,4,1,fp) == 1);
+  ok = ok && (fwrite(mask,1,size,fp) == (size_t)size);
+  ok = (fclose(fp) == 0) && ok;
+
+  if (!ok || rename(tmp,name) != 0) {
+    fprintf(stderr,"dis_save: could not write %s\n",name);
+    remove(tmp);
+    return 0;
+  }
+  return 1;
+}
+
+/********************************************************************
+*                   Sweep over all the densities                    *
+*                                                                   *
+*  The rho[] need not be sorted. Returns the number of files        *
+*  written.                                                         *
+********************************************************************/
+int dis_sweep(int l, unsigned long seed, int nrho, const double *rho)
+{
+  int size = l*l;
+  int *order = malloc(size*sizeof(int));
+  int *ptr = malloc(size*sizeof(int));
+  int *target = malloc(nrho*sizeof(int));
+  char *mask = malloc(size);
+  int big = -1, bigsize = 0, written = 0;
+
+  if (order==NULL || ptr==NULL || target==NULL || mask==NULL) {
+    fprintf(stderr,"dis_sweep: out of memory (L = %d)\n",l);
+    exit(1);
+  }
+
+  start_randomic(seed);
+  for (int i = 0; i < size; i++) order[i] = i;
+  for (int i = size-1; i > 0; i--) {
+    int j = FRANDOM*(i+1);
+    int t = order[i]; order[i] = order[j]; order[j] = t;
+  }
+
+  nz_empty = -size-1;
+  for (int i = 0; i < size; i++) ptr[i] = nz_empty;
+  for (int r = 0; r < nrho; r++) target[r] = dis_count(l,rho[r]);
+
+  for (int k = 0; k <= size; k++) {
+    if (k > 0) {
+      int s = order[k-1];
+      int nb[4] = { (s+1)%l + (s/l)*l, (s-1+l)%l + (s/l)*l, (s-l+size)%size, (s+l)%size };
+      int root = s;
+      ptr[s] = -1;
+      for (int j = 0; j < 4; j++) {
+        if (ptr[nb[j]] != nz_empty) root = nz_union(ptr,root,nz_find(ptr,nb[j]));
+      }
+      if (-ptr[root] > bigsize) {
+        big = root;
+        bigsize = -ptr[root];
+      }
+    }
+    for (int r = 0; r < nrho; r++) {
+      if (target[r] != k) continue;
+      int rb = (k > 0) ? nz_find(ptr,big) : -1;
+      for (int i = 0; i < size; i++) {
+        if (ptr[i] == nz_empty) mask[i] = 0;
+        else mask[i] = (nz_find(ptr,i) == rb) ? 2 : 1;
+      }
+      written += dis_save(l,rho[r],seed,k,bigsize,mask);
+    }
+  }
+
+  free(order);
+  free(ptr);
+  free(target);
+  free(mask);
+  return written;
+}
+
+/********************************************************************
+*                         Read one mask                             *
+********************************************************************/
+int dis_load(int l, double rho, unsigned long seed, char *mask)
+{
+  char name[300],magic[8];
+  int size = l*l;
+  int fl,n,largest,ok;
+  double frho;
+  unsigned long fseed;
+  FILE *fp;
+
+  dis_name(name,sizeof name,l,rho,seed);
+  fp = fopen(name,"rb");
+  if (fp == NULL) return 0;
+
+  ok = (fread(magic,1,8,fp) == 8) && (memcmp(magic,dis_magic,8) == 0);
+  ok = ok && (fread(&fl,4,1,fp) == 1) && (fl == l);
+  ok = ok && (fread(&frho,8,1,fp) == 1) && (dis_count(l,frho) == dis_count(l,rho));
+  ok = ok && (fread(&fseed,sizeof fseed,1,fp) == 1) && (fseed == seed);
+  ok = ok && (fread(&n,4,1,fp) == 1) && (fread(&largest,4,1,fp) == 1);
+  ok = ok && (fread(mask,1,size,fp) == (size_t)size);
+  fclose(fp);
+
+  if (!ok) fprintf(stderr,"dis_load: %s is not a disorder file of these parameters\n",name);
+  return ok;
+}
+
+void dis_get(int l, double rho, unsigned long seed, char *mask)
+{
+  if (dis_load(l,rho,seed,mask)) return;
+  if (dis_sweep(l,seed,1,&rho) == 1 && dis_load(l,rho,seed,mask)) return;
+  fprintf(stderr,"dis_get: no disorder for L = %d, n = %d, seed = %ld\n",l,dis_count(l,rho),seed);
+  exit(1);
+}
+
+#endif
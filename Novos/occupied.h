@@ -0,0 +1,65 @@
+/********************************************************************
+***                     Occupied Sites Index                      ***
+***                   Last Modified: 19/10/2026                   ***
+***                                                               ***
+***  The agents of a diluted lattice, site[0..n-1], and the place ***
+***  of each site in that list, pos[i] (-1 for a vacancy). An     ***
+***  agent is drawn with one random number, in place of           ***
+***                                                               ***
+***     while (spin[site]==0)site = FRANDOM*N;                    ***
+***                                                               ***
+***  (1/RHO draws on average), and a hop to a vacancy keeps both  ***
+***  arrays right in O(1). Include after mc.h (FRANDOM).          ***
+***                                                               ***
+***  occ_init(o,spin,size)   list of the sites with spin != 0     ***
+***  occ_pick(o)             site of an agent, uniformly          ***
+***  occ_move(o,from,to)     the agent at "from" hopped to "to"   ***
+********************************************************************/
+
+#ifndef OCCUPIED_H
+#define OCCUPIED_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  int n;        /* number of agents                       */
+  int *site;    /* site of each agent                     */
+  int *pos;     /* agent at each site, -1 for a vacancy   */
+} occupied;
+
+/********************************************************************
+*                       Index of the agents                         *
+********************************************************************/
+void occ_init(occupied *o, const int *spin, int size)
+{
+  o->site = malloc(size*sizeof(int));
+  o->pos = malloc(size*sizeof(int));
+  if(o->site==NULL || o->pos==NULL){
+    fprintf(stderr,"occ_init: out of memory (%d sites)\n",size);
+    exit(1);
+  }
+  o->n = 0;
+  for(int i=0; i<size; i++){
+    if(spin[i]!=0){
+      o->pos[i] = o->n;
+      o->site[o->n++] = i;
+    }
+    else o->pos[i] = -1;
+  }
+}
+
+int occ_pick(occupied *o)
+{
+  return o->site[(int)(FRANDOM*o->n)];
+}
+
+void occ_move(occupied *o, int from, int to)
+{
+  int a = o->pos[from];
+  o->site[a] = to;
+  o->pos[to] = a;
+  o->pos[from] = -1;
+}
+
+#endif
@@ -16,10 +16,15 @@
 // -DRESET  [full reset case]
 // -DGRESET [gamma reset case]
 // -DINTRANS [intrans case]
+// -DWIDTH [interface heights (+1 spins of each column) kept up to date at every flip, with the width and the height-height correlation in _2.dsf at every measurement]
+// -DBAND [only the band of rows around the interface is drawn, widened when a flip reaches a row outside; the increments the rest gives and gets are settled lazily]
 
 // -DDEBUG [debug program]
 // -DVISUAL [live gif of the evolution]
+// -DVSTREAM=1|2 -DVFPS=30 -DVDOWN=2 [with VISUAL: binary/raw RGB stream, fps limit, downsampling (see visual.h)]
 // -DSNAPSHOTS -I ~/VotanteLAD/liblat2eps/ -llat2eps [snapshots of the system]
+// -DPNGSNAPS [with SNAPSHOTS, PNG snapshots instead of EPS]
+// -DCHECKPOINT=600 [checkpoint every 600 s of wall time, a new run of the same parameters resumes a dead one (see checkpoint.h)]
 
 /***************************************************************
  *                            INCLUDES                      
@@ -36,6 +41,14 @@
   #include <lat2eps.h>
 #endif
 #include "mc.h"
+#include "visual.h"
+#include "schedule.h"
+#ifdef CHECKPOINT
+  #if((VISUAL==1)||(SNAPSHOTS==1))
+    #error "CHECKPOINT needs the output files (no VISUAL or SNAPSHOTS)"
+  #endif
+  #include "checkpoint.h"
+#endif
 
 /****************************************************************
  *                       PARAMETERS DEFINITIONS                      
@@ -68,9 +81,23 @@
   #define BINARY      0
 #endif
 
-#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale.
+#define LOGSCALE    0 // 0 --> measures logaritmically spaced, 1 --> measures in logscale, 2 --> measures linearly spaced.
 #define SIMPLIFIED  1 // 1 --> simplify the algorithm to alpha=beta=1 to avoid calculations
 
+#if(BAND==1)
+  #if(NBINARY==1)
+    #error "BAND needs the binary wall (no NBINARY)"
+  #endif
+#endif
+#if(WIDTH==1)
+  #if(NBINARY==1)
+    #error "WIDTH needs the binary wall (no NBINARY)"
+  #endif
+  #if((VISUAL==1)||(SNAPSHOTS==1))
+    #error "WIDTH needs the output files (no VISUAL or SNAPSHOTS)"
+  #endif
+#endif
+
 /***************************************************************
  *                            FUNCTIONS                       
  **************************************************************/
@@ -78,10 +105,22 @@
 void initialize(void); 
 void openfiles(void); 
 void sweep(void); 
+void interact(int,int);
+#if(BAND==1)
+  void bandinit(void);
+  void settle(int);
+  double addeta(double,long);
+  void widen(int);
+  void bringall(void);
+  long poisson(double);
+#endif
+#if(WIDTH==1)
+  void heightinit(void);
+  void column(int);
+  void widths(int);
+#endif
 void visualize(int,unsigned long); 
 void states(void); 
-void measures1(void); 
-void measures2(void);
 #ifdef SNAPSHOTS
   void snap(void);  
 #endif
@@ -92,19 +131,33 @@ void connections(int,int);
 int percolates2d(int);
 bool exists(const char*);
 bool probcheck(double);
+#ifdef CHECKPOINT
+  void checkpoint(int,int);
+  void restore(int*,int*);
+#endif
 
 /***************************************************************
  *                         GLOBAL VARIABLES                   
  **************************************************************/
 
 FILE *fp1,*fp2;
-int *spin,**neigh,*memory,*measures,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+int *spin,**neigh,*memory,*zealot,*right,*left,*up, *down, sum, sumz, activesum;
+schedule measures;
 int *siz, *label, *his, *qt, cl1, numc, mx1, mx2;
 int probperc0,probperc1;
 int hull_perimeter;
 char root_name[200];
 unsigned long seed;
 double *certainty;
+int resumed=0;
+#if(BAND==1)
+  int *valid,*nvalid,bandlo,bandhi;
+  double *tband,tnow;
+#endif
+#if(WIDTH==1)
+  int *height,nlags,lag[32];
+  long long hsum,hsum2,hdiff[32];
+#endif
 
 /***************************************************************
  *                          MAIN PROGRAM  
@@ -129,24 +182,37 @@ int main(void){
 
 
   int k=0;
+  int j0=0;
   initialize();
+  #ifdef CHECKPOINT
+    if(resumed==1)restore(&j0,&k);
+  #endif
 
-  for (int j=0;j<=MCS+1;j++)  {
+  for (int j=j0;j<=MCS+1;j++)  {
     #if(VISUAL==1)
       visualize(j,seed);
       sweep();
     #else
+      #ifdef CHECKPOINT
+        if(ck_due(CHECKPOINT))checkpoint(j,k);
+      #endif
       if( ( qt[0]==0 ) | ( qt[1]==0 ) ){
         states();
         hoshen_kopelman();
         fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",j,(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
-        while(measures[k]!=0){
-          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",measures[k],(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
+        #if(WIDTH==1)
+          widths(j);
+        #endif
+        while(sched_time(&measures,k)!=0){
+          fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",sched_time(&measures,k),(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
+          #if(WIDTH==1)
+            widths(sched_time(&measures,k));
+          #endif
           k++;
         }           
         break;
       }
-      if (measures[k]==j) {  
+      if (sched_time(&measures,k)==j) {  
         #if(SNAPSHOTS==1)
           snap();   
           k++;        
@@ -154,6 +220,9 @@ int main(void){
           states();
           hoshen_kopelman();
           fprintf(fp1,"%d %.8f %.8f %.8f %.8f %.8f %d %.8f %d %d\n",j,(double)sum/N,(double)sumz/N,(double)activesum/N,(double)numc/N,(double)mx1/N,probperc0,(double)mx2/N,probperc1,qt[0]);
+          #if(WIDTH==1)
+            widths(j);
+          #endif
           k++;
         #endif
       }
@@ -164,6 +233,12 @@ int main(void){
   #if(SNAPSHOTS==0)
   fclose(fp1);
   #endif
+  #if(WIDTH==1)
+    fclose(fp2);
+  #endif
+  #ifdef CHECKPOINT
+    ck_done(root_name,seed);
+  #endif
 
 }
 /***************************************************************
@@ -172,12 +247,16 @@ int main(void){
 void initialize(void) {
  
   start_randomic(seed);
+  /* the first numbers after start_randomic still carry the seeding
+     (a bias of ~10 sigma in qt at t=1 over 20000 runs with BAND,
+     which spends them all at the interface): thrown away, whatever
+     the sweep */
+  for (int w=0; w<100000; w++)(void)RANDOM;
 
-  his = malloc(N*sizeof(int));
+  his = malloc((N+1)*sizeof(int));
   spin = malloc(N*sizeof(int));
   neigh = (int**)malloc(N*sizeof(int*));
   memory = malloc(N*sizeof(int));
-  measures = malloc(MCS*sizeof(int));
   zealot = malloc(N*sizeof(int));
   right = malloc(N*sizeof(int));
   left = malloc(N*sizeof(int));
@@ -230,10 +309,19 @@ void initialize(void) {
     down[i] = neigh[i][3];
   }
 
+  #if(BAND==1)
+    bandinit();
+  #endif
+  #if(WIDTH==1)
+    heightinit();
+  #endif
+
   #if(LOGSCALE==1)
-    measures1(); 
+    sched_decades(&measures,MCS);
+  #elif(LOGSCALE==2)
+    sched_linear(&measures,MCS,MEASURES);
   #else
-    measures2();
+    sched_log(&measures,MCS,MEASURES);
   #endif
 
 }
@@ -242,156 +330,370 @@ void initialize(void) {
  *               MCS routine
  ***************************************************************/
 void sweep(void) {
+  #if(BAND==1)
+    double tend = floor(tnow) + 1;
+    for(;;){
+      int m = (bandhi-bandlo+1)*L;
+      if(m<=0)break;
+      double dt = -log(1-FRANDOM)/m;
+      if(tnow+dt>=tend)break;
+      tnow += dt;
+      int site = bandlo*L + (int)(FRANDOM*m);
+      int neighbour = valid[4*site + (int)(FRANDOM*nvalid[site])];
+      int old = spin[site];
+      settle(site);
+      settle(neighbour);
+      interact(site,neighbour);
+      if(spin[site]!=old){
+        for(int d=0; d<nvalid[site]; d++){
+          int w = valid[4*site+d];
+          int r = w/L;
+          if((r<bandlo || r>bandhi) && spin[w]!=spin[site])widen(r);
+        }
+      }
+    }
+    tnow = tend;
+  #else
+    for (int n=0; n<N; n++) {
+      int site = FRANDOM*N;
+      int dir = FRANDOM*4;
+      int neighbour=neigh[site][dir];
+      while(neighbour==-1){
+        dir=FRANDOM*4;
+        neighbour = neigh[site][dir];
+      }
+      interact(site,neighbour);
+    }
+  #endif
+}
+
+/****************************************************************
+ *               Pair interaction (focal site, neighbour)
+ ***************************************************************/
+void interact(int site, int neighbour) {
+  #if(SIMPLIFIED==1)
+    if(spin[site]!=spin[neighbour]) {
+      if(zealot[site] == 0){
+        #if(NBINARY==0)
+          memory[site]=1;
+          qt[(spin[site] + 1 )/2]--;
+          spin[site] = spin[neighbour];
+          qt[(spin[neighbour] + 1 )/2]++;
+          #if(WIDTH==1)
+            column(site);
+          #endif
+        #else
+          memory[spin[site]]--;
+          spin[site] = spin[neighbour];
+          memory[spin[site]]++;
+        #endif
+      }
 
-  for (int n=0; n<N; n++) {
-    int site = FRANDOM*N;
-    int dir = FRANDOM*4;
-    int neighbour=neigh[site][dir];
-    while(neighbour==-1){
-      dir=FRANDOM*4;
-      neighbour = neigh[site][dir];
+      certainty[neighbour] += DETA;
+
+      #if(RESET==2)
+        certainty[site] = certainty[site]/GAMMA;
+      #endif
+      #if(RESET==1)
+        certainty[site] = 0;
+      #endif
+      #if(RESET==0)
+        certainty[site] -= DETA;
+      #endif     
+
+      #if(INTRANS==0)
+        if(certainty[site]<=THRESHOLD)zealot[site]=0;
+      #endif
+
+      if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
     }
+    else{
+      certainty[site] += DETA;
+      certainty[neighbour] += DETA;
+      if(certainty[site]>=THRESHOLD)zealot[site]=1;
+      if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+    }
+  #else
+    bool acc1 = probcheck(ALPHA);
+    bool acc2 = probcheck(BETA);
+    if(spin[site]!=spin[neighbour]) {
+      if(zealot[site] == 0){
+        if(acc1==true) {
 
-    #if(SIMPLIFIED==1)
-      if(spin[site]!=spin[neighbour]) {
-        if(zealot[site] == 0){
           #if(NBINARY==0)
             memory[site]=1;
-            qt[(spin[site] + 1 )/2]--;
             spin[site] = spin[neighbour];
-            qt[(spin[neighbour] + 1 )/2]++;
+            #if(WIDTH==1)
+              column(site);
+            #endif
           #else
             memory[spin[site]]--;
             spin[site] = spin[neighbour];
             memory[spin[site]]++;
           #endif
-        }
 
-        certainty[neighbour] += DETA;
+          #if(RESET==2)
+            certainty[site] = certainty[site]/GAMMA;
+          #endif
 
-        #if(RESET==2)
-          certainty[site] = certainty[site]/GAMMA;
-        #endif
-        #if(RESET==1)
-          certainty[site] = 0;
-        #endif
-        #if(RESET==0)
-          certainty[site] -= DETA;
-        #endif     
+          #if(RESET==1)
+            certainty[site] = 0;
+          #endif
 
-        #if(INTRANS==0)
-          if(certainty[site]<=THRESHOLD)zealot[site]=0;
-        #endif
+          #if(RESET==0)
+            certainty[site] -= DETA;
+          #endif
 
-        if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
-        continue;
-      }
-      else{
-        certainty[site] += DETA;
-        certainty[neighbour] += DETA;
-        if(certainty[site]>=THRESHOLD)zealot[site]=1;
-        if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
-        continue;
-      }
-    #else
-      bool acc1 = probcheck(ALPHA);
-      bool acc2 = probcheck(BETA);
-      if(spin[site]!=spin[neighbour]) {
-        if(zealot[site] == 0){
-          if(acc1==true) {
-
-            #if(NBINARY==0)
-              memory[site]=1;
-              spin[site] = spin[neighbour];
-            #else
-              memory[spin[site]]--;
-              spin[site] = spin[neighbour];
-              memory[spin[site]]++;
-            #endif
+          certainty[neighbour] += DETA;
+          #if(INTRANS==0)
+            if(certainty[site]<=THRESHOLD)zealot[site]=0;
+          #endif
+          if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
 
-            #if(RESET==2)
-              certainty[site] = certainty[site]/GAMMA;
-            #endif
+        }
+        else{
+          certainty[site] += DETA;
+          certainty[neighbour] -= DETA;
 
-            #if(RESET==1)
-              certainty[site] = 0;
-            #endif
+          #if(INTRANS==0)
+            if(certainty[neighbour]<=THRESHOLD)zealot[neighbour]=0;
+          #endif
 
-            #if(RESET==0)
-              certainty[site] -= DETA;
-            #endif
+          if(certainty[site]>=THRESHOLD)zealot[site]=1;
+        }
+      }
 
-            certainty[neighbour] += DETA;
-            #if(INTRANS==0)
-              if(certainty[site]<=THRESHOLD)zealot[site]=0;
-            #endif
-            if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+      else {
+        if (acc2==true) {
 
-          }
-          else{
-            certainty[site] += DETA;
-            certainty[neighbour] -= DETA;
+          certainty[neighbour] += DETA;
 
-            #if(INTRANS==0)
-              if(certainty[neighbour]<=THRESHOLD)zealot[neighbour]=0;
-            #endif
+          #if(RESET==2)
+            certainty[site] = certainty[site]/GAMMA;
+          #endif
+
+          #if(RESET==1)
+            certainty[site] = 0;
+          #endif
+
+          #if(RESET==0)
+            certainty[site] -= DETA;
+          #endif
+          
+          #if(INTRANS==0)
+            if(certainty[site]<=THRESHOLD)zealot[site]=0;
+          #endif
+          if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
 
-            if(certainty[site]>=THRESHOLD)zealot[site]=1;
-          }
         }
 
-        else {
-          if (acc2==true) {
+        else  {
+          certainty[site] -= DETA;
+          certainty[neighbour] += DETA;
 
-            certainty[neighbour] += DETA;
+          #if(INTRANS==0)
+            if(certainty[site]<=THRESHOLD)zealot[site]=0;
+          #endif
 
-            #if(RESET==2)
-              certainty[site] = certainty[site]/GAMMA;
-            #endif
+          if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
 
-            #if(RESET==1)
-              certainty[site] = 0;
-            #endif
+        }
 
-            #if(RESET==0)
-              certainty[site] -= DETA;
-            #endif
-            
-            #if(INTRANS==0)
-              if(certainty[site]<=THRESHOLD)zealot[site]=0;
-            #endif
-            if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+      }
 
-          }
+    }
 
-          else  {
-            certainty[site] -= DETA;
-            certainty[neighbour] += DETA;
+    else{
+      certainty[site] += DETA;
+      certainty[neighbour] += DETA;
+      if(certainty[site]>=THRESHOLD)zealot[site]=1;
+      if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+    }
+  #endif
+}
 
-            #if(INTRANS==0)
-              if(certainty[site]<=THRESHOLD)zealot[site]=0;
-            #endif
+#if(BAND==1)
+/****************************************************************
+ *               Active band (BAND)
+ *
+ * Both half-planes start as zealots of certainty THRESHOLD, so a
+ * site stays untouched by the dynamics while it is a zealot and
+ * agrees with all its neighbours: every draw it takes part in only
+ * adds DETA to both certainties. Only the rows bandlo..bandhi,
+ * which hold every other site, are drawn, each site at rate 1
+ * (exponential times of mean 1/(sites in the band) between draws,
+ * as for N draws per MCS at large N), the direction uniform among
+ * the valid neighbours of the open boundaries (valid, nvalid).
+ * When a flip leaves a site outside the band disagreeing with a
+ * neighbour, its row joins the band; the band never shrinks.
+ *
+ * A site gets DETA at rate 1 from its own draws if it is outside
+ * the band, and at rate 1/nvalid[u] from each neighbour u outside
+ * the band; these Poisson numbers are settled up to tnow when the
+ * site takes part in a draw, before its row or a neighbouring one
+ * joins the band (which changes the rate) and before measurements.
+ ***************************************************************/
+void bandinit(void) {
+  valid = malloc(4*N*sizeof(int));
+  nvalid = malloc(N*sizeof(int));
+  tband = malloc(N*sizeof(double));
+  bandlo = L;
+  bandhi = -1;
+  for (int i=0; i<N; i++) {
+    nvalid[i] = 0;
+    for(int d=0; d<4; d++){
+      int w = neigh[i][d];
+      if(w==-1)continue;
+      valid[4*i+nvalid[i]++] = w;
+      if(spin[w]!=spin[i]){
+        if(i/L<bandlo)bandlo = i/L;
+        if(i/L>bandhi)bandhi = i/L;
+      }
+    }
+    tband[i] = 0;
+  }
+  tnow = 0;
+}
 
-            if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
+void settle(int _site) {
+  int r = _site/L;
+  if(r>bandlo && r<bandhi)return;
+  double rate = (r<bandlo || r>bandhi) ? 1 : 0;
+  for(int d=0; d<nvalid[_site]; d++){
+    int w = valid[4*_site+d];
+    if(w/L<bandlo || w/L>bandhi)rate += 1./nvalid[w];
+  }
+  if(rate>0){
+    long n = poisson(rate*(tnow-tband[_site]));
+    if(n>0){
+      certainty[_site] = addeta(certainty[_site],n);
+      if(certainty[_site]>=THRESHOLD)zealot[_site]=1;
+    }
+  }
+  tband[_site] = tnow;
+}
 
-          }
+/* n increments of DETA, one at a time up to THRESHOLD as the draws
+   would add them (ten 0.1 make 0.9999999999999999, not 1), the rest
+   at once */
+double addeta(double c, long n) {
+  while(n>0 && c<THRESHOLD){
+    c += DETA;
+    n--;
+  }
+  return c + n*DETA;
+}
 
-        }
+/* row _row joins the band: settle the rates it changes first */
+void widen(int _row) {
+  for(int r=_row-1; r<=_row+1; r++){
+    if(r<0 || r>=L)continue;
+    for(int i=r*L; i<(r+1)*L; i++)settle(i);
+  }
+  if(_row<bandlo)bandlo = _row;
+  if(_row>bandhi)bandhi = _row;
+}
 
-      }
+void bringall(void) {
+  for (int i=0; i<N; i++) {
+    int r = i/L;
+    if(r<=bandlo || r>=bandhi)settle(i);
+  }
+}
 
-      else{
-        certainty[site] += DETA;
-        certainty[neighbour] += DETA;
-        if(certainty[site]>=THRESHOLD)zealot[site]=1;
-        if(certainty[neighbour]>=THRESHOLD)zealot[neighbour]=1;
-        continue;
-      }
-    #endif    
+/****************************************************************
+ *               Poisson numbers
+ *
+ *  Inversion for small means, transformed rejection (PTRS,
+ *  Hormann 1993) for the others.
+ ***************************************************************/
+long poisson(double mu) {
+  if(mu<10){
+    double p = exp(-mu), f = p, u = FRANDOM;
+    long n = 0;
+    while(u>f && n<1000){
+      n++;
+      p *= mu/n;
+      f += p;
+    }
+    return n;
+  }
+  double slam = sqrt(mu), loglam = log(mu);
+  double b = 0.931 + 2.53*slam, a = -0.059 + 0.02483*b;
+  double invalpha = 1.1239 + 1.1328/(b-3.4), vr = 0.9277 - 3.6224/(b-2);
+  for(;;){
+    double u = FRANDOM-0.5, v = FRANDOM, us = 0.5-fabs(u);
+    long k = (long)floor((2*a/us + b)*u + mu + 0.43);
+    if(us>=0.07 && v<=vr)return k;
+    if(k<0 || (us<0.013 && v>us))continue;
+    if(log(v) + log(invalpha) - log(a/(us*us)+b) <= -mu + k*loglam - lgamma(k+1))return k;
+  }
+}
+#endif
 
+#if(WIDTH==1)
+/****************************************************************
+ *               Interface heights (WIDTH)
+ *
+ * The height of column x is its number of +1 spins, height[x].
+ * It is where the interface would sit with the overhangs and the
+ * islands of the column pushed to their own side, so every flip
+ * changes it by +-1 whatever the shape of the interface. Kept
+ * with it, at each flip and in O(nlags):
+ *
+ *   hsum = sum_x h_x,  hsum2 = sum_x h_x^2,
+ *   hdiff[k] = sum_{x<L-r} (h_{x+r}-h_x)^2,  r = lag[k] = 1,2,4,..<=L/2
+ *
+ * so a measurement gives <h>, w^2 = <h^2>-<h>^2 and the height-
+ * height correlation C(r) = hdiff/(L-r) without looking at the
+ * lattice.
+ ***************************************************************/
+void heightinit(void) {
+  if(height==NULL)height = malloc(L*sizeof(int));
+  for(int x=0; x<L; x++){
+    height[x] = 0;
+    for(int i=x; i<N; i+=L)if(spin[i]==1)height[x]++;
   }
+  hsum = 0;
+  hsum2 = 0;
+  for(int x=0; x<L; x++){
+    hsum += height[x];
+    hsum2 += (long long)height[x]*height[x];
+  }
+  nlags = 0;
+  for(int r=1; r<=L/2 && nlags<32; r*=2){
+    lag[nlags] = r;
+    hdiff[nlags] = 0;
+    for(int x=0; x+r<L; x++){
+      long long d = height[x+r]-height[x];
+      hdiff[nlags] += d*d;
+    }
+    nlags++;
+  }
+}
+
+/* _site has just flipped to spin[_site] */
+void column(int _site) {
+  int x = _site%L;
+  int d = spin[_site];
+  for(int k=0; k<nlags; k++){
+    int r = lag[k];
+    if(x+r<L)hdiff[k] += 1 - 2*d*(height[x+r]-height[x]);
+    if(x-r>=0)hdiff[k] += 1 + 2*d*(height[x]-height[x-r]);
+  }
+  hsum += d;
+  hsum2 += 2*d*height[x] + 1;
+  height[x] += d;
 }
 
+void widths(int _tempo) {
+  double h = (double)hsum/L;
+  fprintf(fp2,"%d %.8f %.8f",_tempo,h,(double)hsum2/L-h*h);
+  for(int k=0; k<nlags; k++)fprintf(fp2," %.8f",(double)hdiff[k]/(L-lag[k]));
+  fprintf(fp2,"\n");
+}
+#endif
+
 /****************************************************************
  *               Check states numbers
  ***************************************************************/
@@ -403,6 +705,9 @@ void states(void) {
   #endif
   sumz=0;
   activesum=0;
+  #if(BAND==1)
+    bringall();
+  #endif
   for (int i=0; i<N; i++) {
     #if(NBINARY==0)
       if (memory[i]!=0) sum--;
@@ -415,37 +720,6 @@ void states(void) {
     if (spin[down[i]]!=spin[i]) activesum++;
   }
 }
- /**************************************************************
- *                       Measures Vector     // Medidas Logarítmicas
- *************************************************************/
-void measures1(void){
-  int n=0;
-  int m=0;
-  for(int i=0; i<=MCS; i++) {
-    if(i%((int)pow(10,n))==0) {
-      measures[m]=i;
-      m++;
-    }
-    if(i/(pow(10,n))==10)n++;
-  }
-  return;
-}
-
- /**************************************************************
- *                       Measures Vector    // Número de medidas
- *************************************************************/
-void measures2(void){
-  int m=0;
-  measures[0]=0;
-  double temp = pow((double)MCS,1.0/(MEASURES-1));
-  for(int i=0;i<MEASURES;i++){
-    measures[i] = (int)pow(temp,(double) i);
-    if(measures[i]<=m)measures[i]=m+1;
-    m=measures[i];
-  }
-  return;
-}
-
 /**************************************************************
  *                      Teste
  *************************************************************/
@@ -461,18 +735,31 @@ bool probcheck(double _ALPHA) {
  *************************************************************/
 void visualize(int _j,unsigned long _seed) {
   int l;
-  printf("pl '-' matrix w image t 'time = %d seed = %ld'\n",_j,_seed);
-  for(l = N-1; l >= 0; l--) {
-    #if(NBINARY==0)
-      if(zealot[l]==1)printf("%d ", spin[l]+1);
-      else printf("%d ", spin[l]);
-    #else
+  int8_t *cell = vis_frame(L,L);
+  char title[100];
+  if(cell==NULL)return;
+  #if(BAND==1)
+    bringall();
+  #endif
+  #if(NBINARY==0)
+    for(l = N-1; l >= 0; l--) {
+      if(zealot[l]==1)cell[N-1-l]=spin[l]+1;
+      else cell[N-1-l]=spin[l];
+    }
+  #endif
+  snprintf(title,sizeof title,"time = %d seed = %ld",_j,_seed);
+  #if(NBINARY==0)
+    vis_emit(title);
+  #else
+    /* the labels (0..N-1) do not fit the byte frame: plain matrix */
+    printf("pl '-' matrix w image t '%s'\n",title);
+    for(l = N-1; l >= 0; l--) {
       if(zealot[l]==1)printf("%d ", -spin[l]);
       else printf("%d ", spin[l]);
-    #endif
-    if( l%L == 0 ) printf("\n");
-  }
-  printf("e\n");
+      if( l%L == 0 ) printf("\n");
+    }
+    printf("e\n");
+  #endif
 }
 
 #ifdef SNAPSHOTS
@@ -483,6 +770,11 @@ void visualize(int _j,unsigned long _seed) {
     int l;
     int identifier = 0;
     char teste[100];
+    uint8_t *frame = malloc(N*sizeof(uint8_t));
+
+    #if(BAND==1)
+      bringall();
+    #endif
 
     lat2eps_init(L,L);
     lat2eps_set_color(0,0x00000); //black
@@ -496,22 +788,33 @@ void visualize(int _j,unsigned long _seed) {
 
     for(l=0; l<N; l++) {
       if(spin[l]==1) {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,4);
-        else lat2eps_set_site(l%L,l/L,6);
+        if(certainty[l]>=1)frame[l]=4;
+        else frame[l]=6;
       }
       else {
-        if(certainty[l]>=1)lat2eps_set_site(l%L,l/L,5);
-        else lat2eps_set_site(l%L,l/L,7);
+        if(certainty[l]>=1)frame[l]=5;
+        else frame[l]=7;
       } 
     }
 
-    snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+    #ifdef PNGSNAPS
+      const char *ext = "png";
+    #else
+      const char *ext = "eps";
+    #endif
+    snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     while(exists(teste)==true) {
       identifier++;
-      snprintf(teste,sizeof teste,"sd%ld[%d].eps",seed,identifier);
+      snprintf(teste,sizeof teste,"sd%ld[%d].%s",seed,identifier,ext);
     }
-    lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #ifdef PNGSNAPS
+      lat2eps_gen_raster(teste,frame,L,L,3,LAT2EPS_PNG);
+    #else
+      lat2eps_set_lattice(frame);
+      lat2eps_gen_eps(teste,0,0,L,L,1,3);
+    #endif
     lat2eps_release();
+    free(frame);
   }
 #endif
 
@@ -581,6 +884,9 @@ void hoshen_kopelman(void) {
   
   mx1 = temp1;
   mx2 = temp2;
+
+  free(label);
+  free(siz);
   
   return;
 }
@@ -702,9 +1008,12 @@ void openfiles(void) {
   #endif
 
  unsigned long identifier = seed;
+  #ifdef CHECKPOINT
+    resumed = ck_claim(root_name,&identifier);
+  #endif
   #if(DEBUG==0)
     sprintf(teste,"%s_sd%ld_1.dsf",root_name,identifier);
-    while(exists(teste)==true) {
+    while((resumed==0)&&(exists(teste)==true)) {
       identifier+=2;
       sprintf(teste,"%s_sd%ld_1.dsf",root_name,identifier);
     }
@@ -712,8 +1021,16 @@ void openfiles(void) {
   sprintf(teste,"%s_sd%ld",root_name,identifier);
   seed=identifier;
 
+  #ifdef CHECKPOINT
+    if(resumed==0)ck_lock(root_name,seed);
+  #endif
+
   sprintf(output_file1,"%s_1.dsf",teste);
-  fp1 = fopen(output_file1,"w");
+  fp1 = fopen(output_file1,(resumed==1)?"r+":"w");
+  if(fp1==NULL){
+    fprintf(stderr,"%s can not be opened\n",output_file1);
+    exit(1);
+  }
   fprintf(fp1,"# LAD Voter Model 2D Main Output\n");
   fprintf(fp1,"# Seed: %ld\n",seed);
   fprintf(fp1,"# Linear size: %d\n",L);
@@ -725,6 +1042,98 @@ void openfiles(void) {
   fprintf(fp1,"\n\n");
   fflush(fp1);
 
+  #if(WIDTH==1)
+    char output_file2[300];
+    sprintf(output_file2,"%s_2.dsf",teste);
+    fp2 = fopen(output_file2,(resumed==1)?"r+":"w");
+    if(fp2==NULL){
+      fprintf(stderr,"%s can not be opened\n",output_file2);
+      exit(1);
+    }
+    fprintf(fp2,"# LAD Voter Model 2D Interface Width\n");
+    fprintf(fp2,"# Seed: %ld\n",seed);
+    fprintf(fp2,"# Linear size: %d\n",L);
+    fprintf(fp2,"# Irreversible: %d\n",INTRANS);
+    fprintf(fp2,"# Incremento: %.6f\n",DETA);
+    fprintf(fp2,"# Reset (1 Full, 2 Gamma reset): %d\n",RESET);
+    fprintf(fp2,"# Time Height W2");
+    for(int r=1; r<=L/2; r*=2)fprintf(fp2," C(%d)",r);
+    fprintf(fp2,"\n\n\n");
+    fflush(fp2);
+  #endif
+
   return;
 
 }
+
+#ifdef CHECKPOINT
+/**************************************************************
+ *               Checkpoint / restart routines
+ *************************************************************/
+
+int ckstate(ckblock *b, int *j, int *k, long *length, long *length2) {
+  int nb=0;
+  b[nb++] = (ckblock)CK_VAR(seed);
+  b[nb++] = (ckblock){"j",j,sizeof(int)};
+  b[nb++] = (ckblock){"k",k,sizeof(int)};
+  b[nb++] = (ckblock){"length1",length,sizeof(long)};
+  #if(WIDTH==1)
+    b[nb++] = (ckblock){"length2",length2,sizeof(long)};
+  #endif
+  b[nb++] = (ckblock)CK_ARRAY(spin,N);
+  b[nb++] = (ckblock)CK_ARRAY(certainty,N);
+  b[nb++] = (ckblock)CK_ARRAY(zealot,N);
+  b[nb++] = (ckblock)CK_ARRAY(memory,N);
+  #if(NBINARY==0)
+    b[nb++] = (ckblock)CK_ARRAY(qt,2);
+  #else
+    b[nb++] = (ckblock)CK_ARRAY(qt,N);
+  #endif
+  b[nb++] = (ckblock)CK_VAR(ira);
+  b[nb++] = (ckblock)CK_VAR(ip);
+  b[nb++] = (ckblock)CK_VAR(ip1);
+  b[nb++] = (ckblock)CK_VAR(ip2);
+  b[nb++] = (ckblock)CK_VAR(ip3);
+  #if(BAND==1)
+    b[nb++] = (ckblock)CK_VAR(bandlo);
+    b[nb++] = (ckblock)CK_VAR(bandhi);
+    b[nb++] = (ckblock)CK_ARRAY(tband,N);
+  #endif
+  return nb;
+}
+
+void checkpoint(int j, int k) {
+  ckblock b[20];
+  long length,length2=0;
+
+  fflush(fp1);
+  fsync(fileno(fp1));
+  length = ftell(fp1);
+  #if(WIDTH==1)
+    fflush(fp2);
+    fsync(fileno(fp2));
+    length2 = ftell(fp2);
+  #endif
+  if(ck_save(root_name,seed,b,ckstate(b,&j,&k,&length,&length2))==0){
+    fprintf(stderr,"checkpoint of %s_sd%ld can not be written\n",root_name,seed);
+  }
+}
+
+void restore(int *j, int *k) {
+  ckblock b[20];
+  long length,length2;
+
+  if(ck_load(root_name,seed,b,ckstate(b,j,k,&length,&length2))==0){
+    fprintf(stderr,"checkpoint of %s_sd%ld is corrupted or from another build\n",root_name,seed);
+    exit(1);
+  }
+  #if(BAND==1)
+    tnow = *j;
+  #endif
+  ck_truncate(fp1,length);
+  #if(WIDTH==1)
+    ck_truncate(fp2,length2);
+    heightinit();
+  #endif
+}
+#endif
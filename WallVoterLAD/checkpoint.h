@@ -0,0 +1,272 @@
+/********************************************************************
+***                     Checkpoint / Restart                      ***
+***                   Last Modified: 19/10/2026                   ***
+***                                                               ***
+***  A checkpoint is a binary file (root_sd<seed>.ckpt) with a    ***
+***  list of named blocks (lattice arrays, counters, RNG state    ***
+***  and the length of each output file) closed by a checksum:    ***
+***                                                               ***
+***     "LADCKPT" 0 | version | nblocks                           ***
+***     name[16] | size (8 bytes) | data          (per block)     ***
+***     FNV-1a of everything above                                ***
+***                                                               ***
+***  It is written to root_sd<seed>.ckpt.tmp, synced and renamed  ***
+***  over the old one, so a run killed at any moment leaves       ***
+***  either the previous or the new checkpoint, never a partial   ***
+***  one. Each running job holds a lock (flock) on                ***
+***  root_sd<seed>.lock; a new job of the same parameters takes   ***
+***  over the first checkpoint whose lock is free (its job died), ***
+***  keeps its seed, cuts the outputs back to the checkpoint and  ***
+***  goes on appending to them.                                   ***
+********************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <glob.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#define CK_MAGIC    "LADCKPT"
+#define CK_VERSION  1
+#define CK_NAMELEN  16
+
+typedef struct {
+  const char *name;
+  void *data;
+  size_t size;
+} ckblock;
+
+/* block of a variable or of an array of n elements */
+#define CK_VAR(v)      { #v, &(v), sizeof(v) }
+#define CK_ARRAY(p,n)  { #p, (p), (size_t)(n)*sizeof(*(p)) }
+
+/********************************************************************
+***                      Variable Declarations                    ***
+********************************************************************/
+
+int ck_lockfd = -1;          /* lock of the running job          */
+time_t ck_last = 0;          /* wall clock of the last checkpoint */
+
+/********************************************************************
+*                         File names                                *
+********************************************************************/
+void ck_name(char *name, size_t len, const char *root, unsigned long seed, const char *ext)
+{
+  snprintf(name,len,"%s_sd%ld.%s",root,seed,ext);
+}
+
+/********************************************************************
+*                          Checksum                                 *
+********************************************************************/
+uint32_t ck_fnv(uint32_t h, const void *data, size_t len)
+{
+  const unsigned char *p = data;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/********************************************************************
+*                         Lock of a job                             *
+*                                                                   *
+*  Return: 1 if the lock was taken (kept until the job ends)        *
+********************************************************************/
+int ck_lock(const char *root, unsigned long seed)
+{
+  char name[400];
+  int fd;
+
+  ck_name(name,sizeof name,root,seed,"lock");
+  fd = open(name,O_CREAT|O_RDWR,0644);
+  if (fd < 0) return 0;
+  if (flock(fd,LOCK_EX|LOCK_NB) != 0) {
+    close(fd);
+    return 0;
+  }
+  if (ck_lockfd >= 0) close(ck_lockfd);
+  ck_lockfd = fd;
+  return 1;
+}
+
+/********************************************************************
+*                            Save                                   *
+*                                                                   *
+*  Writes the blocks to root_sd<seed>.ckpt atomically.              *
+*  Return: 1 on success                                             *
+********************************************************************/
+int ck_save(const char *root, unsigned long seed, const ckblock *b, int nb)
+{
+  char name[400],tmp[420],bname[CK_NAMELEN];
+  uint32_t h = 2166136261u, version = CK_VERSION, n = nb;
+  uint64_t size;
+  FILE *fp;
+  int i,ok;
+
+  ck_name(name,sizeof name,root,seed,"ckpt");
+  snprintf(tmp,sizeof tmp,"%s.tmp",name);
+  fp = fopen(tmp,"wb");
+  if (fp == NULL) return 0;
+
+  ok = (fwrite(CK_MAGIC,1,8,fp) == 8);
+  ok = ok && (fwrite(&version,4,1,fp) == 1);
+  ok = ok && (fwrite(&n,4,1,fp) == 1);
+  h = ck_fnv(h,CK_MAGIC,8);
+  h = ck_fnv(h,&version,4);
+  h = ck_fnv(h,&n,4);
+  for (i = 0; i < nb && ok; i++) {
+    memset(bname,0,CK_NAMELEN);
+    strncpy(bname,b[i].name,CK_NAMELEN-1);
+    size = b[i].size;
+    ok = (fwrite(bname,1,CK_NAMELEN,fp) == CK_NAMELEN);
+    ok = ok && (fwrite(&size,8,1,fp) == 1);
+    ok = ok && (fwrite(b[i].data,1,b[i].size,fp) == b[i].size);
+    h = ck_fnv(h,bname,CK_NAMELEN);
+    h = ck_fnv(h,&size,8);
+    h = ck_fnv(h,b[i].data,b[i].size);
+  }
+  ok = ok && (fwrite(&h,4,1,fp) == 1);
+  ok = ok && (fflush(fp) == 0) && (fsync(fileno(fp)) == 0);
+  ok = (fclose(fp) == 0) && ok;
+
+  if (!ok || rename(tmp,name) != 0) {
+    remove(tmp);
+    return 0;
+  }
+  ck_last = time(NULL);
+  return 1;
+}
+
+/********************************************************************
+*                            Load                                   *
+*                                                                   *
+*  Reads root_sd<seed>.ckpt into the blocks, which must have the    *
+*  same names and sizes as when saved (same program and defines).   *
+*  Return: 1 on success, 0 if missing, corrupted or incompatible    *
+********************************************************************/
+int ck_load(const char *root, unsigned long seed, const ckblock *b, int nb)
+{
+  char name[400],magic[8],bname[CK_NAMELEN];
+  uint32_t h = 2166136261u, version, n, check;
+  uint64_t size;
+  unsigned char *buf = NULL;
+  FILE *fp;
+  int i,ok;
+
+  ck_name(name,sizeof name,root,seed,"ckpt");
+  fp = fopen(name,"rb");
+  if (fp == NULL) return 0;
+
+  ok = (fread(magic,1,8,fp) == 8) && (memcmp(magic,CK_MAGIC,8) == 0);
+  ok = ok && (fread(&version,4,1,fp) == 1) && (version == CK_VERSION);
+  ok = ok && (fread(&n,4,1,fp) == 1) && ((int)n == nb);
+  h = ck_fnv(h,magic,8);
+  h = ck_fnv(h,&version,4);
+  h = ck_fnv(h,&n,4);
+
+  /* first pass: structure and checksum, the blocks are copied only if all is right */
+  for (i = 0; i < nb && ok; i++) {
+    ok = (fread(bname,1,CK_NAMELEN,fp) == CK_NAMELEN) && (fread(&size,8,1,fp) == 1);
+    ok = ok && (strncmp(bname,b[i].name,CK_NAMELEN-1) == 0) && (size == b[i].size);
+    if (!ok) break;
+    buf = realloc(buf,size > 0 ? size : 1);
+    ok = (buf != NULL) && (fread(buf,1,size,fp) == size);
+    h = ck_fnv(h,bname,CK_NAMELEN);
+    h = ck_fnv(h,&size,8);
+    if (ok) h = ck_fnv(h,buf,size);
+  }
+  ok = ok && (fread(&check,4,1,fp) == 1) && (check == h);
+
+  if (ok) {
+    fseek(fp,16,SEEK_SET);
+    for (i = 0; i < nb && ok; i++) {
+      fseek(fp,CK_NAMELEN+8,SEEK_CUR);
+      ok = (fread(b[i].data,1,b[i].size,fp) == b[i].size);
+    }
+  }
+
+  free(buf);
+  fclose(fp);
+  return ok;
+}
+
+/********************************************************************
+*                           Restart                                 *
+*                                                                   *
+*  ck_claim: looks for a checkpoint of "root" left by a dead job    *
+*            (lock free) and takes it over.                         *
+*            Return: 1 and its seed in *seed, 0 for a new run       *
+*  ck_truncate: cuts an output file back to the length it had at    *
+*               the checkpoint; writing goes on from there          *
+*  ck_done: the run is over, checkpoint and lock are removed        *
+********************************************************************/
+int ck_claim(const char *root, unsigned long *seed)
+{
+  char pattern[400],format[420];
+  unsigned long s;
+  glob_t g;
+  size_t i;
+
+  snprintf(pattern,sizeof pattern,"%s_sd*.ckpt",root);
+  snprintf(format,sizeof format,"%s_sd%%lu.ckpt",root);
+  if (glob(pattern,0,NULL,&g) != 0) return 0;
+
+  for (i = 0; i < g.gl_pathc; i++) {
+    if (sscanf(g.gl_pathv[i],format,&s) != 1) continue;
+    if (!ck_lock(root,s)) continue;
+    *seed = s;
+    globfree(&g);
+    ck_last = time(NULL);
+    return 1;
+  }
+  globfree(&g);
+  return 0;
+}
+
+void ck_truncate(FILE *fp, long length)
+{
+  fflush(fp);
+  if (ftruncate(fileno(fp),length) != 0) {
+    fprintf(stderr,"checkpoint: output can not be truncated\n");
+    exit(1);
+  }
+  fseek(fp,length,SEEK_SET);
+}
+
+void ck_done(const char *root, unsigned long seed)
+{
+  char name[400];
+
+  ck_name(name,sizeof name,root,seed,"ckpt");
+  remove(name);
+  ck_name(name,sizeof name,root,seed,"lock");
+  remove(name);
+  if (ck_lockfd >= 0) close(ck_lockfd);
+  ck_lockfd = -1;
+}
+
+/********************************************************************
+*                           Cadence                                 *
+*                                                                   *
+*  Return: 1 if "seconds" of wall time went by since the last       *
+*          checkpoint (or the start of the run)                     *
+********************************************************************/
+int ck_due(int seconds)
+{
+  time_t now = time(NULL);
+
+  if (ck_last == 0) ck_last = now;
+  return (now - ck_last >= seconds);
+}
+
+#endif
@@ -16,6 +16,8 @@
 #ifndef _LAT2EPS_H
 #define _LAT2EPS_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -27,6 +29,12 @@ extern "C" {
 
 #define LAT2EPS_VERS  "lat2eps 2.0"   /*!< Version string. */
 
+#define LAT2EPS_PPM   0   /*!< Raster format: binary PPM (P6).              */
+#define LAT2EPS_PNG   1   /*!< Raster format: 8-bit indexed PNG.            */
+
+#define LAT2EPS_RLE   0   /*!< EPS encoder: horizontal runs only (one command per row segment). */
+#define LAT2EPS_RECT  1   /*!< EPS encoder: row runs merged vertically into rectangles (default). */
+
 
 /**
 * Initializes the lattice resources. Must be called before any other lat2eps function.
@@ -52,6 +60,13 @@ void lat2eps_release();
 void lat2eps_set_site(unsigned int x, unsigned int y, int s);
 
 
+/**
+* Sets all lattice sites at once from a caller-owned buffer.
+* @param buffer Site values (color indexes), one byte per site, row by row (width * height bytes as given to lat2eps_init()).
+*/
+void lat2eps_set_lattice(const uint8_t *buffer);
+
+
 /**
 * Gets the value of a lattice site.
 * @param x Horizontal coordinate of the site.
@@ -77,6 +92,13 @@ void lat2eps_set_color(unsigned int index, unsigned int pal);
 unsigned int lat2eps_get_color(unsigned int index);
 
 
+/**
+* Selects how lat2eps_gen_eps() encodes the lattice. Both encoders produce the same picture.
+* @param mode LAT2EPS_RECT (default) or LAT2EPS_RLE.
+*/
+void lat2eps_set_encoder(int mode);
+
+
 /**
 * Adds a text message to the EPS output. Must be called before lat2eps_gen_eps().
 * @param x      Horizontal coordinate where the text will be positioned. 0 is the leftmost coordinate, while the maximum value is defined by the lattice width.
@@ -106,6 +128,81 @@ void lat2eps_text_out(float x, float y, float ax, float ay, float angle, unsigne
 int lat2eps_gen_eps(const char *filename, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height, unsigned int border, unsigned int scale);
 
 
+/**
+* Generates a raster image (PPM or PNG) directly from a caller-owned lattice buffer, using the current palette.
+* Does not need lat2eps_init(), and does not touch the lattice set by lat2eps_set_site().
+* @param filename  Name of the image file that will be created, or NULL for outputting to stdout.
+* @param buffer    Site values (color indexes), one byte per site, row by row (width * height bytes).
+* @param width     Lattice width (in sites).
+* @param height    Lattice height (in sites).
+* @param scale     Integer upscaling (e.g., using 3 will create a 3x3 pixel square for each lattice site).
+* @param format    LAT2EPS_PPM or LAT2EPS_PNG.
+* @return          Zero for failure, non-zero for success.
+*/
+int lat2eps_gen_raster(const char *filename, const uint8_t *buffer, unsigned int width, unsigned int height, unsigned int scale, int format);
+
+
+/**
+* Lattice context. Holds the lattice, palette, encoder and text entries of one graphic, so that several graphics can be built at the same time
+* (e.g., one per thread). The lat2eps_ctx_* functions work like the functions of the same name above, which act on a single internal context.
+*/
+typedef struct lat2eps_ctx lat2eps_ctx;
+
+
+/**
+* Creates a context with its own lattice, the default palette and the LAT2EPS_RECT encoder.
+* @param width  Lattice width (in sites).
+* @param height Lattice height (in sites).
+* @return       New context, or NULL for failure. Must be released with lat2eps_ctx_free().
+*/
+lat2eps_ctx *lat2eps_ctx_create(unsigned int width, unsigned int height);
+
+
+/**
+* Releases a context created by lat2eps_ctx_create().
+* @param ctx Context (NULL is ignored).
+*/
+void lat2eps_ctx_free(lat2eps_ctx *ctx);
+
+
+/** Context version of lat2eps_set_site(). */
+void lat2eps_ctx_set_site(lat2eps_ctx *ctx, unsigned int x, unsigned int y, int s);
+
+
+/** Context version of lat2eps_set_lattice(). */
+void lat2eps_ctx_set_lattice(lat2eps_ctx *ctx, const uint8_t *buffer);
+
+
+/** Context version of lat2eps_get_site(). */
+int lat2eps_ctx_get_site(const lat2eps_ctx *ctx, unsigned int x, unsigned int y);
+
+
+/** Context version of lat2eps_set_color(). */
+void lat2eps_ctx_set_color(lat2eps_ctx *ctx, unsigned int index, unsigned int pal);
+
+
+/** Context version of lat2eps_get_color(). */
+unsigned int lat2eps_ctx_get_color(const lat2eps_ctx *ctx, unsigned int index);
+
+
+/** Context version of lat2eps_set_encoder(). */
+void lat2eps_ctx_set_encoder(lat2eps_ctx *ctx, int mode);
+
+
+/** Context version of lat2eps_text_out(). */
+void lat2eps_ctx_text_out(lat2eps_ctx *ctx, float x, float y, float ax, float ay, float angle, unsigned int size, unsigned int color, const char *text);
+
+
+/**
+* Context version of lat2eps_gen_eps(). The PostScript palette definitions are kept in the context and only formatted again for changed colors.
+*/
+int lat2eps_ctx_gen_eps(lat2eps_ctx *ctx, const char *filename, unsigned int xoff, unsigned int yoff, unsigned int width, unsigned int height, unsigned int border, unsigned int scale);
+
+
+/** Context version of lat2eps_gen_raster(), with the palette of the context. */
+int lat2eps_ctx_gen_raster(const lat2eps_ctx *ctx, const char *filename, const uint8_t *buffer, unsigned int width, unsigned int height, unsigned int scale, int format);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */